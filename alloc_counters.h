@@ -0,0 +1,56 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_alloc_counters_h_
+#define e_alloc_counters_h_
+
+// C
+#include <stdint.h>
+
+// Wrap bookkeeping that only exists with --enable-alloc-stats.  Include
+// config.h before this header.
+#ifdef E_ALLOC_STATS
+#define E_ALLOC_STAT(X) do { X; } while (0)
+#else
+#define E_ALLOC_STAT(X) do { } while (0)
+#endif
+
+namespace e
+{
+namespace alloc_counters
+{
+
+void arena_acquire(uint64_t bytes, bool large);
+void arena_release(uint64_t bytes, bool large);
+void arena_retire(uint64_t requested, uint64_t wasted);
+void buffer_create(uint64_t capacity);
+void buffer_destroy(uint64_t capacity);
+
+} // namespace alloc_counters
+} // namespace e
+
+#endif // e_alloc_counters_h_
@@ -0,0 +1,175 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// e
+#include "e/alloc_stats.h"
+#include "e/atomic.h"
+#include "alloc_counters.h"
+
+namespace
+{
+
+uint64_t g_arena_requested = 0;
+uint64_t g_arena_reserved = 0;
+uint64_t g_arena_blocks = 0;
+uint64_t g_arena_large = 0;
+uint64_t g_arena_wasted = 0;
+uint64_t g_arena_high_water = 0;
+uint64_t g_buffers_created = 0;
+uint64_t g_buffers_live = 0;
+uint64_t g_buffer_bytes = 0;
+uint64_t g_buffer_high_water = 0;
+
+void
+raise_high_water(uint64_t* hw, uint64_t val)
+{
+    uint64_t cur = e::atomic::load_64_nobarrier(hw);
+
+    while (cur < val)
+    {
+        uint64_t witness = e::atomic::compare_and_swap_64_nobarrier(hw, cur, val);
+
+        if (witness == cur)
+        {
+            break;
+        }
+
+        cur = witness;
+    }
+}
+
+} // namespace
+
+bool
+e :: alloc_stats_enabled()
+{
+#ifdef E_ALLOC_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+e :: arena_stats :: arena_stats()
+    : bytes_requested(0)
+    , bytes_reserved(0)
+    , blocks(0)
+    , large_objects(0)
+    , bytes_wasted(0)
+    , high_water(0)
+{
+}
+
+e :: buffer_stats :: buffer_stats()
+    : buffers_created(0)
+    , buffers_live(0)
+    , bytes_live(0)
+    , high_water(0)
+{
+}
+
+void
+e :: global_arena_stats(arena_stats* s)
+{
+    s->bytes_requested = e::atomic::load_64_nobarrier(&g_arena_requested);
+    s->bytes_reserved = e::atomic::load_64_nobarrier(&g_arena_reserved);
+    s->blocks = e::atomic::load_64_nobarrier(&g_arena_blocks);
+    s->large_objects = e::atomic::load_64_nobarrier(&g_arena_large);
+    s->bytes_wasted = e::atomic::load_64_nobarrier(&g_arena_wasted);
+    s->high_water = e::atomic::load_64_nobarrier(&g_arena_high_water);
+}
+
+void
+e :: global_buffer_stats(buffer_stats* s)
+{
+    s->buffers_created = e::atomic::load_64_nobarrier(&g_buffers_created);
+    s->buffers_live = e::atomic::load_64_nobarrier(&g_buffers_live);
+    s->bytes_live = e::atomic::load_64_nobarrier(&g_buffer_bytes);
+    s->high_water = e::atomic::load_64_nobarrier(&g_buffer_high_water);
+}
+
+std::ostream&
+e :: operator << (std::ostream& lhs, const arena_stats& rhs)
+{
+    return lhs << "arena_stats(requested=" << rhs.bytes_requested
+               << ", reserved=" << rhs.bytes_reserved
+               << ", blocks=" << rhs.blocks
+               << ", large_objects=" << rhs.large_objects
+               << ", wasted=" << rhs.bytes_wasted
+               << ", high_water=" << rhs.high_water << ")";
+}
+
+std::ostream&
+e :: operator << (std::ostream& lhs, const buffer_stats& rhs)
+{
+    return lhs << "buffer_stats(created=" << rhs.buffers_created
+               << ", live=" << rhs.buffers_live
+               << ", bytes_live=" << rhs.bytes_live
+               << ", high_water=" << rhs.high_water << ")";
+}
+
+void
+e :: alloc_counters :: arena_acquire(uint64_t bytes, bool large)
+{
+    uint64_t reserved = e::atomic::increment_64_nobarrier(&g_arena_reserved, bytes);
+    e::atomic::increment_64_nobarrier(large ? &g_arena_large : &g_arena_blocks, 1);
+    raise_high_water(&g_arena_high_water, reserved);
+}
+
+void
+e :: alloc_counters :: arena_release(uint64_t bytes, bool large)
+{
+    e::atomic::increment_64_nobarrier(&g_arena_reserved, -bytes);
+    e::atomic::increment_64_nobarrier(large ? &g_arena_large : &g_arena_blocks, -1);
+}
+
+void
+e :: alloc_counters :: arena_retire(uint64_t requested, uint64_t wasted)
+{
+    e::atomic::increment_64_nobarrier(&g_arena_requested, requested);
+    e::atomic::increment_64_nobarrier(&g_arena_wasted, wasted);
+}
+
+void
+e :: alloc_counters :: buffer_create(uint64_t capacity)
+{
+    e::atomic::increment_64_nobarrier(&g_buffers_created, 1);
+    e::atomic::increment_64_nobarrier(&g_buffers_live, 1);
+    uint64_t live = e::atomic::increment_64_nobarrier(&g_buffer_bytes, capacity);
+    raise_high_water(&g_buffer_high_water, live);
+}
+
+void
+e :: alloc_counters :: buffer_destroy(uint64_t capacity)
+{
+    e::atomic::increment_64_nobarrier(&g_buffers_live, -1);
+    e::atomic::increment_64_nobarrier(&g_buffer_bytes, -capacity);
+}
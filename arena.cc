@@ -25,49 +25,110 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// C
+#include <assert.h>
+#include <stdint.h>
+
+// STL
+#include <algorithm>
+
 // e
 #include "e/arena.h"
 #include "e/buffer.h"
+#include "alloc_counters.h"
 
 using e::arena;
 
+namespace
+{
+
+const size_t DEFAULT_INITIAL_BLOCK = 4096;
+const size_t DEFAULT_MAX_BLOCK = 1024 * 1024;
+
+inline unsigned char*
+align_up(unsigned char* ptr, size_t align)
+{
+    const uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+    return reinterpret_cast<unsigned char*>((p + align - 1) & ~(uintptr_t(align) - 1));
+}
+
+} // namespace
+
 arena :: arena()
-    : m_to_free()
+    : m_source(block_source::malloc_source())
+    , m_blocks()
+    , m_next(0)
+    , m_large()
+    , m_to_free()
     , m_buffers()
+    , m_destructors()
+    , m_next_block(DEFAULT_INITIAL_BLOCK)
+    , m_max_block(DEFAULT_MAX_BLOCK)
     , m_start()
     , m_limit()
+    , m_requested(0)
+    , m_reserved(0)
+    , m_wasted(0)
+    , m_high_water(0)
 {
 }
 
-arena :: ~arena()
+arena :: arena(size_t initial_block, size_t max_block)
+    : m_source(block_source::malloc_source())
+    , m_blocks()
+    , m_next(0)
+    , m_large()
+    , m_to_free()
+    , m_buffers()
+    , m_destructors()
+    , m_next_block(std::max(initial_block, size_t(64)))
+    , m_max_block(std::max(max_block, m_next_block))
+    , m_start()
+    , m_limit()
+    , m_requested(0)
+    , m_reserved(0)
+    , m_wasted(0)
+    , m_high_water(0)
 {
-    for (size_t i = 0; i < m_to_free.size(); ++i)
-    {
-        free(m_to_free[i]);
-    }
+}
 
-    for (size_t i = 0; i < m_buffers.size(); ++i)
-    {
-        delete m_buffers[i];
-    }
+arena :: arena(size_t initial_block, size_t max_block, block_source* source)
+    : m_source(source)
+    , m_blocks()
+    , m_next(0)
+    , m_large()
+    , m_to_free()
+    , m_buffers()
+    , m_destructors()
+    , m_next_block(std::max(initial_block, size_t(64)))
+    , m_max_block(std::max(max_block, m_next_block))
+    , m_start()
+    , m_limit()
+    , m_requested(0)
+    , m_reserved(0)
+    , m_wasted(0)
+    , m_high_water(0)
+{
+}
+
+arena :: ~arena()
+{
+    clear();
 }
 
 void
 arena :: reserve(size_t sz)
 {
-    if (m_start + sz <= m_limit)
+    if (sz <= size_t(m_limit - m_start))
     {
         return;
     }
 
-    unsigned char* tmp = NULL;
-    raw_allocate(sz, &tmp);
-
-    if (tmp)
-    {
-        m_start = tmp;
-        m_limit = m_start + sz;
-    }
+    new_block(sz);
 }
 
 void
@@ -79,17 +140,79 @@ arena :: allocate(size_t sz, char** ptr)
 void
 arena :: allocate(size_t sz, unsigned char** ptr)
 {
-    if (m_start + sz <= m_limit)
+    E_ALLOC_STAT(m_requested += sz);
+
+    if (sz <= size_t(m_limit - m_start))
+    {
+        *ptr = m_start;
+        m_start += sz;
+    }
+    else if (is_large(sz))
+    {
+        raw_allocate(sz, 0, ptr);
+    }
+    else if (new_block(sz))
     {
         *ptr = m_start;
         m_start += sz;
     }
     else
     {
-        raw_allocate(sz, ptr);
+        *ptr = NULL;
+    }
+}
+
+void
+arena :: allocate_aligned(size_t sz, size_t align, unsigned char** ptr)
+{
+    assert(align > 0 && (align & (align - 1)) == 0);
+    E_ALLOC_STAT(m_requested += sz);
+
+    if (m_start)
+    {
+        unsigned char* aligned = align_up(m_start, align);
+
+        if (aligned <= m_limit && sz <= size_t(m_limit - aligned))
+        {
+            E_ALLOC_STAT(m_wasted += aligned - m_start);
+            *ptr = aligned;
+            m_start = aligned + sz;
+            return;
+        }
+    }
+
+    if (is_large(sz + align - 1))
+    {
+        raw_allocate(sz, align, ptr);
+    }
+    else if (new_block(sz + align - 1))
+    {
+        *ptr = align_up(m_start, align);
+        E_ALLOC_STAT(m_wasted += *ptr - m_start);
+        m_start = *ptr + sz;
+    }
+    else
+    {
+        *ptr = NULL;
     }
 }
 
+bool
+arena :: extend(unsigned char* ptr, size_t old_sz, size_t new_sz)
+{
+    assert(old_sz <= new_sz);
+
+    if (!ptr || ptr + old_sz != m_start ||
+        new_sz - old_sz > size_t(m_limit - m_start))
+    {
+        return false;
+    }
+
+    E_ALLOC_STAT(m_requested += new_sz - old_sz);
+    m_start += new_sz - old_sz;
+    return true;
+}
+
 void
 arena :: takeover(char* ptr)
 {
@@ -108,28 +231,141 @@ arena :: takeover(e::buffer* buf)
     m_buffers.push_back(buf);
 }
 
+arena::savepoint
+arena :: mark() const
+{
+    savepoint sp;
+    sp.m_next = m_next;
+    sp.m_start = m_start;
+    sp.m_limit = m_limit;
+    sp.m_large = m_large.size();
+    sp.m_to_free = m_to_free.size();
+    sp.m_buffers = m_buffers.size();
+    sp.m_destructors = m_destructors.size();
+    return sp;
+}
+
 void
-arena :: clear()
+arena :: rewind(const savepoint& sp)
 {
-    for (size_t i = 0; i < m_to_free.size(); ++i)
+    assert(sp.m_large <= m_large.size());
+    assert(sp.m_to_free <= m_to_free.size());
+    assert(sp.m_buffers <= m_buffers.size());
+    assert(sp.m_destructors <= m_destructors.size());
+
+    // destroy objects first, as they may refer to memory freed below
+    while (m_destructors.size() > sp.m_destructors)
+    {
+        destructor d = m_destructors.back();
+        m_destructors.pop_back();
+        d.func(d.ptr);
+    }
+
+    for (size_t i = sp.m_large; i < m_large.size(); ++i)
+    {
+        E_ALLOC_STAT(m_reserved -= m_large[i].size);
+        E_ALLOC_STAT(alloc_counters::arena_release(m_large[i].size, true));
+        m_source->release(m_large[i].base, m_large[i].size);
+    }
+
+    for (size_t i = sp.m_to_free; i < m_to_free.size(); ++i)
     {
         free(m_to_free[i]);
     }
 
-    for (size_t i = 0; i < m_buffers.size(); ++i)
+    for (size_t i = sp.m_buffers; i < m_buffers.size(); ++i)
     {
         delete m_buffers[i];
     }
+
+    m_large.resize(sp.m_large);
+    m_to_free.resize(sp.m_to_free);
+    m_buffers.resize(sp.m_buffers);
+    m_next = sp.m_next;
+    m_start = sp.m_start;
+    m_limit = sp.m_limit;
+}
+
+void
+arena :: reset()
+{
+    rewind(savepoint());
+}
+
+void
+arena :: clear()
+{
+    reset();
+
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+    {
+        E_ALLOC_STAT(m_reserved -= m_blocks[i].size);
+        E_ALLOC_STAT(alloc_counters::arena_release(m_blocks[i].size, false));
+        m_source->release(m_blocks[i].base, m_blocks[i].size);
+    }
+
+    m_blocks.clear();
+    E_ALLOC_STAT(alloc_counters::arena_retire(m_requested, m_wasted));
+    E_ALLOC_STAT(m_requested = m_wasted = 0);
+}
+
+void
+arena :: stats(arena_stats* s) const
+{
+    *s = arena_stats();
+#ifdef E_ALLOC_STATS
+    s->bytes_requested = m_requested;
+    s->bytes_wasted = m_wasted;
+    s->high_water = m_high_water;
+    s->blocks = m_blocks.size();
+    s->large_objects = m_large.size();
+    s->bytes_reserved = m_reserved;
+#endif
+}
+
+bool
+arena :: new_block(size_t sz)
+{
+    E_ALLOC_STAT(m_wasted += m_limit - m_start);
+
+    if (m_next < m_blocks.size() && m_blocks[m_next].size >= sz)
+    {
+        m_start = m_blocks[m_next].base;
+        m_limit = m_start + m_blocks[m_next].size;
+        ++m_next;
+        return true;
+    }
+
+    size_t block_sz = std::max(sz, m_next_block);
+    unsigned char* base = m_source->allocate(&block_sz, sizeof(void*));
+
+    if (!base)
+    {
+        return false;
+    }
+
+    // a retained block that is too small stays queued behind this one
+    m_blocks.insert(m_blocks.begin() + m_next, block(base, block_sz));
+    ++m_next;
+    m_start = base;
+    m_limit = base + block_sz;
+    m_next_block = std::min(m_next_block * 2, m_max_block);
+    E_ALLOC_STAT(m_reserved += block_sz);
+    E_ALLOC_STAT(alloc_counters::arena_acquire(block_sz, false));
+    E_ALLOC_STAT(m_high_water = std::max(m_high_water, m_reserved));
+    return true;
 }
 
 void
-arena :: raw_allocate(size_t sz, unsigned char** ptr)
+arena :: raw_allocate(size_t sz, size_t align, unsigned char** ptr)
 {
-    unsigned char* tmp = reinterpret_cast<unsigned char*>(malloc(sz));
-    *ptr = tmp;
+    *ptr = m_source->allocate(&sz, std::max(align, sizeof(void*)));
 
-    if (tmp)
+    if (*ptr)
     {
-        m_to_free.push_back(tmp);
+        m_large.push_back(block(*ptr, sz));
+        E_ALLOC_STAT(m_reserved += sz);
+        E_ALLOC_STAT(alloc_counters::arena_acquire(sz, true));
+        E_ALLOC_STAT(m_high_water = std::max(m_high_water, m_reserved));
     }
 }
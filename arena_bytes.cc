@@ -0,0 +1,153 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// STL
+#include <algorithm>
+
+// e
+#include "e/arena_bytes.h"
+
+using e::arena_bytes;
+
+namespace
+{
+
+const size_t MIN_CAPACITY = 32;
+
+} // namespace
+
+arena_bytes :: arena_bytes(arena* a)
+    : m_arena(a)
+    , m_data(NULL)
+    , m_size(0)
+    , m_cap(0)
+{
+}
+
+arena_bytes :: ~arena_bytes() throw ()
+{
+}
+
+void
+arena_bytes :: reserve(size_t sz)
+{
+    if (sz <= m_cap)
+    {
+        return;
+    }
+
+    size_t new_cap = std::max(m_cap, MIN_CAPACITY);
+
+    while (new_cap < sz && new_cap <= SIZE_MAX / 2)
+    {
+        new_cap *= 2;
+    }
+
+    new_cap = std::max(new_cap, sz);
+
+    if (m_arena->extend(m_data, m_cap, new_cap))
+    {
+        m_cap = new_cap;
+        return;
+    }
+
+    unsigned char* tmp = NULL;
+    m_arena->allocate(new_cap, &tmp);
+
+    if (!tmp)
+    {
+        abort();
+    }
+
+    if (m_size)
+    {
+        memmove(tmp, m_data, m_size);
+    }
+
+    m_data = tmp;
+    m_cap = new_cap;
+}
+
+e::packer
+arena_bytes :: pack()
+{
+    return pack_at(m_size);
+}
+
+e::packer
+arena_bytes :: pack_at(size_t off)
+{
+    return e::packer(*static_cast<packer::bytes_manager*>(this), off);
+}
+
+void
+arena_bytes :: clear()
+{
+    m_data = NULL;
+    m_size = 0;
+    m_cap = 0;
+}
+
+uint8_t*
+arena_bytes :: prepare(size_t off, size_t sz)
+{
+    if (SIZE_MAX - off < sz)
+    {
+        abort();
+    }
+
+    const size_t new_size = off + sz;
+
+    if (new_size > m_cap)
+    {
+        reserve(new_size);
+    }
+
+    if (off > m_size)
+    {
+        memset(m_data + m_size, 0, off - m_size);
+    }
+
+    m_size = std::max(m_size, new_size);
+    return m_data + off;
+}
+
+void
+arena_bytes :: write(size_t off, const uint8_t* ptr, size_t ptr_sz)
+{
+    uint8_t* dst = prepare(off, ptr_sz);
+
+    if (ptr_sz > 0)
+    {
+        memmove(dst, ptr, ptr_sz);
+    }
+}
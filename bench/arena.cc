@@ -0,0 +1,237 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Chase pointers through nodes scattered across an arena's blocks, comparing
+// malloc-backed blocks with mmap-backed blocks with and without huge pages.
+//
+// usage: bench/arena [megabytes [rounds]]
+
+// C
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// POSIX
+#include <unistd.h>
+
+// Linux
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// STL
+#include <algorithm>
+#include <vector>
+
+// e
+#include "e/arena.h"
+#include "e/block_source.h"
+
+namespace
+{
+
+struct node
+{
+    node* next;
+    uint64_t payload[7];
+};
+
+uint64_t
+now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Count data-TLB read misses for this thread; -1 where perf events are not
+// available, as in many containers.
+class tlb_counter
+{
+    public:
+        tlb_counter();
+        ~tlb_counter() throw ();
+
+    public:
+        void start();
+        int64_t stop();
+
+    private:
+        int m_fd;
+};
+
+tlb_counter :: tlb_counter()
+    : m_fd(-1)
+{
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+tlb_counter :: ~tlb_counter() throw ()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+    }
+}
+
+void
+tlb_counter :: start()
+{
+#ifdef __linux__
+    if (m_fd >= 0)
+    {
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+int64_t
+tlb_counter :: stop()
+{
+    int64_t count = -1;
+#ifdef __linux__
+    if (m_fd >= 0)
+    {
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+        {
+            count = -1;
+        }
+    }
+#endif
+    return count;
+}
+
+void
+run(const char* name, e::block_source* source, size_t megabytes, unsigned rounds)
+{
+    const size_t num_nodes = megabytes * 1024 * 1024 / sizeof(node);
+    e::arena a(1024 * 1024, 64 * 1024 * 1024, source);
+    std::vector<node*> nodes(num_nodes);
+    uint64_t t_alloc = now();
+
+    for (size_t i = 0; i < num_nodes; ++i)
+    {
+        nodes[i] = a.create<node>();
+
+        if (!nodes[i])
+        {
+            fprintf(stderr, "%s: allocation failed\n", name);
+            return;
+        }
+    }
+
+    t_alloc = now() - t_alloc;
+    uint64_t rng = 0x9e3779b97f4a7c15ULL;
+
+    for (size_t i = num_nodes - 1; i > 0; --i)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        std::swap(nodes[i], nodes[rng % (i + 1)]);
+    }
+
+    for (size_t i = 0; i < num_nodes; ++i)
+    {
+        nodes[i]->next = nodes[(i + 1) % num_nodes];
+    }
+
+    node* n = nodes[0];
+    std::vector<node*>().swap(nodes);
+    tlb_counter tlb;
+    tlb.start();
+    uint64_t t_chase = now();
+
+    for (size_t i = 0; i < num_nodes * rounds; ++i)
+    {
+        n = n->next;
+    }
+
+    t_chase = now() - t_chase;
+    int64_t misses = tlb.stop();
+    printf("%-12s alloc %8.2f ms  chase %8.2f ms  %6.2f ns/hop  dTLB misses ",
+           name, t_alloc / 1e6, t_chase / 1e6,
+           double(t_chase) / (num_nodes * rounds));
+
+    if (misses >= 0)
+    {
+        printf("%lld\n", static_cast<long long>(misses));
+    }
+    else
+    {
+        printf("n/a\n");
+    }
+
+    // keep the chase from being optimized away
+    if (n == NULL)
+    {
+        abort();
+    }
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[])
+{
+    size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 256;
+    unsigned rounds = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+
+    if (argc > 3 || megabytes == 0 || rounds == 0)
+    {
+        fprintf(stderr, "usage: %s [megabytes [rounds]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    e::mmap_block_source small_pages(false);
+    e::mmap_block_source huge_pages(true);
+    run("malloc", e::block_source::malloc_source(), megabytes, rounds);
+    run("mmap", &small_pages, megabytes, rounds);
+    run("mmap+huge", &huge_pages, megabytes, rounds);
+    printf("%llu of the huge page blocks were advised MADV_HUGEPAGE\n",
+           static_cast<unsigned long long>(huge_pages.huge_page_blocks()));
+    return EXIT_SUCCESS;
+}
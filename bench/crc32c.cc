@@ -0,0 +1,145 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Checksum a buffer with a byte-at-a-time table, as the log and replication
+// paths do outside libe, and with e::crc32c.
+//
+// usage: bench/crc32c [bytes [iterations]]
+
+// C
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// STL
+#include <vector>
+
+// e
+#include "e/crc32c.h"
+
+namespace
+{
+
+uint64_t
+now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint32_t table[256];
+
+void
+init_table()
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            crc = (crc >> 1) ^ (-(crc & 1) & 0x82f63b78);
+        }
+
+        table[i] = crc;
+    }
+}
+
+uint32_t
+bytewise(uint32_t crc, const uint8_t* data, size_t sz)
+{
+    crc = ~crc;
+
+    for (size_t i = 0; i < sz; ++i)
+    {
+        crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xff];
+    }
+
+    return ~crc;
+}
+
+void
+report(const char* name, uint64_t ns, size_t bytes, unsigned iterations)
+{
+    printf("%-24s %8.2f GB/s\n", name, double(bytes) * iterations / ns);
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[])
+{
+    size_t bytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 65536;
+    unsigned iterations = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000;
+
+    if (argc > 3 || bytes == 0 || iterations == 0)
+    {
+        fprintf(stderr, "usage: %s [bytes [iterations]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    init_table();
+    std::vector<uint8_t> buf(bytes);
+
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        buf[i] = i * 0x9e3779b1U >> 24;
+    }
+
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+    uint64_t start;
+
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        a = bytewise(a, &buf[0], bytes);
+    }
+
+    report("byte table", now() - start, bytes, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        b = e::crc32c_portable(b, &buf[0], bytes);
+    }
+
+    report("slicing-by-8", now() - start, bytes, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        c = e::crc32c(c, &buf[0], bytes);
+    }
+
+    report("e::crc32c", now() - start, bytes, iterations);
+    return a == b && b == c ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// Pack and unpack arrays of uint64_t element by element, as pack_array did
+// before, and with the bulk conversions.
+//
+// usage: bench/pack_array [elements [iterations]]
+
+// C
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// STL
+#include <memory>
+#include <vector>
+
+// e
+#include "e/basic_packer.h"
+#include "e/buffer.h"
+#include "e/serialization.h"
+
+namespace
+{
+
+uint64_t
+now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void
+report(const char* name, uint64_t ns, size_t elements, unsigned iterations)
+{
+    const double total = double(elements) * iterations;
+    printf("%-24s %8.3f ns/element %8.2f GB/s\n", name, ns / total,
+           total * sizeof(uint64_t) / ns);
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[])
+{
+    size_t elements = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    unsigned iterations = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+
+    if (argc > 3 || elements == 0 || iterations == 0)
+    {
+        fprintf(stderr, "usage: %s [elements [iterations]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint64_t> v(elements);
+
+    for (size_t i = 0; i < elements; ++i)
+    {
+        v[i] = i * 0x9e3779b97f4a7c15ULL;
+    }
+
+    std::auto_ptr<e::buffer> buf(e::buffer::create(elements * sizeof(uint64_t)));
+    std::vector<uint64_t> out(elements);
+    uint64_t start;
+
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::packer pa = buf->pack_at(0);
+
+        for (size_t i = 0; i < elements; ++i)
+        {
+            pa = pa << v[i];
+        }
+    }
+
+    report("pack loop", now() - start, elements, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        buf->pack_at(0) << e::pack_array<uint64_t>(&v[0], elements);
+    }
+
+    report("pack bulk", now() - start, elements, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::buffer_packer(buf.get(), 0) << e::pack_array<uint64_t>(&v[0], elements);
+    }
+
+    report("buffer_packer bulk", now() - start, elements, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::unpacker up = buf->unpack_from(0);
+
+        for (size_t i = 0; i < elements; ++i)
+        {
+            up = up >> out[i];
+        }
+    }
+
+    report("unpack loop", now() - start, elements, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        buf->unpack_from(0) >> e::unpack_array<uint64_t>(&out[0], elements);
+    }
+
+    report("unpack bulk", now() - start, elements, iterations);
+    return out == v ? EXIT_SUCCESS : EXIT_FAILURE;
+}
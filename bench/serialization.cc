@@ -0,0 +1,289 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Encode and decode every type with an E_SERIALIZATION_TRIPLET, slices of
+// several sizes, vectors, and varints, into a std::string and into an
+// e::buffer.  Run it before and after a change to serialization.cc.
+//
+// usage: bench/serialization [iterations [filter]]
+//
+// Only benchmarks whose name contains the filter are run.
+
+#define __STDC_LIMIT_MACROS
+
+// C
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// POSIX
+#include <netinet/in.h>
+
+// STL
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// po6
+#include <po6/net/hostname.h>
+#include <po6/net/ipaddr.h>
+#include <po6/net/location.h>
+
+// e
+#include "e/buffer.h"
+#include "e/serialization.h"
+
+namespace
+{
+
+// Each run packs enough values to fill about this many bytes.
+const size_t BATCH_BYTES = 64 * 1024;
+
+uint64_t
+now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void
+report(const char* name, const char* target, size_t value_sz,
+       uint64_t ops, uint64_t encode_ns, uint64_t decode_ns)
+{
+    const double bytes = double(value_sz) * ops;
+    printf("%-24s %-8s %10.2f %8.3f %10.2f %8.3f\n", name, target,
+           double(encode_ns) / ops, bytes / encode_ns,
+           double(decode_ns) / ops, bytes / decode_ns);
+}
+
+// Keep the compiler from discarding decoded values.
+volatile uint64_t sink;
+
+template <typename T>
+void
+consume(const T& t)
+{
+    sink += e::pack_size(t);
+}
+
+// wrappers are not values, so the varint benchmark decodes through this
+struct varint
+{
+    varint() : x(0) {}
+    varint(uint64_t _x) : x(_x) {}
+    uint64_t x;
+};
+
+size_t
+pack_size(const varint& v)
+{
+    return e::varint_length(v.x);
+}
+
+e::packer
+operator << (e::packer pa, const varint& v)
+{
+    return pa << e::pack_varint(v.x);
+}
+
+e::unpacker
+operator >> (e::unpacker up, varint& v)
+{
+    return up >> e::unpack_varint(v.x);
+}
+
+void
+consume(const varint& v)
+{
+    sink += v.x;
+}
+
+template <typename T>
+void
+run(const char* name, const T& value, unsigned iterations)
+{
+    using e::pack_size;
+    const size_t value_sz = pack_size(value);
+    const size_t batch = std::max(size_t(1), BATCH_BYTES / value_sz);
+    const uint64_t ops = uint64_t(batch) * iterations;
+    T out = T();
+    uint64_t start;
+    uint64_t encode_ns;
+    uint64_t decode_ns;
+
+    std::string str;
+    str.reserve(batch * value_sz);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        str.clear();
+        e::packer pa(&str);
+
+        for (size_t i = 0; i < batch; ++i)
+        {
+            pa = pa << value;
+        }
+    }
+
+    encode_ns = now() - start;
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::unpacker up(str);
+
+        for (size_t i = 0; i < batch; ++i)
+        {
+            up = up >> out;
+        }
+
+        if (up.error())
+        {
+            abort();
+        }
+    }
+
+    decode_ns = now() - start;
+    consume(out);
+    report(name, "string", value_sz, ops, encode_ns, decode_ns);
+
+    std::auto_ptr<e::buffer> buf(e::buffer::create(batch * value_sz));
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::packer pa = buf->pack_at(0);
+
+        for (size_t i = 0; i < batch; ++i)
+        {
+            pa = pa << value;
+        }
+    }
+
+    encode_ns = now() - start;
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::unpacker up = buf->unpack_from(0);
+
+        for (size_t i = 0; i < batch; ++i)
+        {
+            up = up >> out;
+        }
+
+        if (up.error())
+        {
+            abort();
+        }
+    }
+
+    decode_ns = now() - start;
+    consume(out);
+    report(name, "buffer", value_sz, ops, encode_ns, decode_ns);
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[])
+{
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 100;
+    const char* filter = argc > 2 ? argv[2] : "";
+
+    if (argc > 3 || iterations == 0)
+    {
+        fprintf(stderr, "usage: %s [iterations [filter]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%-24s %-8s %10s %8s %10s %8s\n", "benchmark", "target",
+           "enc ns/op", "enc GB/s", "dec ns/op", "dec GB/s");
+
+#define BENCH(NAME, VALUE) \
+    if (strstr(NAME, filter)) \
+    { \
+        run(NAME, VALUE, iterations); \
+    }
+
+    BENCH("int8_t", int8_t(-5))
+    BENCH("int16_t", int16_t(-500))
+    BENCH("int32_t", int32_t(-500000))
+    BENCH("int64_t", int64_t(-5000000000LL))
+    BENCH("uint8_t", uint8_t(5))
+    BENCH("uint16_t", uint16_t(500))
+    BENCH("uint32_t", uint32_t(500000))
+    BENCH("uint64_t", uint64_t(5000000000ULL))
+    BENCH("double", double(3.14159))
+
+    const std::string bytes(65536, 'x');
+    BENCH("slice/0", e::slice())
+    BENCH("slice/16", e::slice(bytes.data(), 16))
+    BENCH("slice/256", e::slice(bytes.data(), 256))
+    BENCH("slice/4096", e::slice(bytes.data(), 4096))
+    BENCH("slice/65536", e::slice(bytes.data(), 65536))
+
+    in_addr v4;
+    v4.s_addr = htonl(0x7f000001);
+    po6::net::ipaddr ip(v4);
+    po6::net::location loc;
+    loc.address = ip;
+    loc.port = 2012;
+    po6::net::hostname host;
+    host.address = "example.org";
+    host.port = 2012;
+    BENCH("ipaddr", ip)
+    BENCH("location", loc)
+    BENCH("hostname", host)
+
+    BENCH("varint/1", varint(100))
+    BENCH("varint/5", varint(1ULL << 30))
+    BENCH("varint/10", varint(UINT64_MAX))
+
+    std::vector<uint32_t> u32(1000);
+    std::vector<uint64_t> u64(1000);
+    std::vector<e::slice> slices(100, e::slice(bytes.data(), 32));
+
+    for (size_t i = 0; i < u64.size(); ++i)
+    {
+        u32[i] = i * 2654435761U;
+        u64[i] = i * 0x9e3779b97f4a7c15ULL;
+    }
+
+    BENCH("vector<uint32_t>/1000", u32)
+    BENCH("vector<uint64_t>/1000", u64)
+    BENCH("vector<slice/32>/100", slices)
+
+#undef BENCH
+
+    return EXIT_SUCCESS;
+}
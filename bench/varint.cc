@@ -0,0 +1,281 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Compute lengths of, encode, and decode varints drawn from a uniform
+// distribution of bit lengths and from a skewed one where most values fit
+// in a byte.  Signed varints carry the same magnitudes with alternating signs
+// and group varints carry the low 32 bits of the same values.
+//
+// usage: bench/varint [values [iterations]]
+
+// C
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// STL
+#include <vector>
+
+// e
+#include "e/varint.h"
+
+namespace
+{
+
+uint64_t
+now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t
+xorshift(uint64_t* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+// varint_length as it was, a shift per seven bits
+int
+length_loop(uint64_t v)
+{
+    int len = 1;
+
+    while (v >= 128)
+    {
+        v >>= 7;
+        len++;
+    }
+
+    return len;
+}
+
+void
+report(const char* dist, const char* name, uint64_t ns, size_t values, unsigned iterations)
+{
+    printf("%-8s %-24s %8.3f ns/value\n", dist, name, double(ns) / (double(values) * iterations));
+}
+
+volatile uint64_t sink;
+
+void
+run(const char* dist, const std::vector<uint64_t>& v, unsigned iterations)
+{
+    const size_t n = v.size();
+    std::vector<char> buf(n * VARINT_64_MAX_SIZE + 16);
+    std::vector<uint64_t> out(n);
+    uint64_t start;
+    uint64_t total = 0;
+    char* end = &buf[0];
+
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            total += length_loop(v[i] ^ it);
+        }
+    }
+
+    report(dist, "length loop", now() - start, n, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            total += e::varint_length(v[i] ^ it);
+        }
+    }
+
+    report(dist, "varint_length", now() - start, n, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        end = &buf[0];
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            end = e::varint64_encode(end, v[i]);
+        }
+    }
+
+    report(dist, "varint64_encode", now() - start, n, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        end = &buf[0];
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            end = e::varint64_encode_slack(end, v[i]);
+        }
+    }
+
+    report(dist, "varint64_encode_slack", now() - start, n, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        const char* ptr = &buf[0];
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            ptr = e::varint64_decode(ptr, end, &out[i]);
+        }
+    }
+
+    report(dist, "varint64_decode", now() - start, n, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::varint64_decode_n(&buf[0], end, &out[0], n);
+    }
+
+    report(dist, "varint64_decode_n", now() - start, n, iterations);
+
+    // the same magnitudes with alternating signs, as zigzag varints
+    std::vector<int64_t> sv(n);
+    std::vector<int64_t> sout(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        sv[i] = static_cast<int64_t>(v[i] >> 1) * (i & 1 ? -1 : 1);
+    }
+
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        end = e::svarint64_encode_n(&buf[0], &buf[0] + buf.size(), &sv[0], n);
+    }
+
+    report(dist, "svarint64_encode_n", now() - start, n, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        e::svarint64_decode_n(&buf[0], end, &sout[0], n);
+    }
+
+    report(dist, "svarint64_decode_n", now() - start, n, iterations);
+
+    if (sout != sv)
+    {
+        abort();
+    }
+
+    // the low 32 bits of the same values, four to a group
+    const size_t groups = n / 4;
+    std::vector<uint32_t> v32(groups * 4);
+    std::vector<uint32_t> out32(groups * 4);
+
+    for (size_t i = 0; i < v32.size(); ++i)
+    {
+        v32[i] = v[i];
+    }
+
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        end = &buf[0];
+
+        for (size_t i = 0; i < groups; ++i)
+        {
+            end = e::group_varint_encode(end, &v32[i * 4]);
+        }
+    }
+
+    report(dist, "group_varint_encode", now() - start, groups * 4, iterations);
+    start = now();
+
+    for (unsigned it = 0; it < iterations; ++it)
+    {
+        const char* ptr = &buf[0];
+
+        for (size_t i = 0; i < groups; ++i)
+        {
+            ptr = e::group_varint_decode(ptr, end, &out32[i * 4]);
+        }
+    }
+
+    report(dist, "group_varint_decode", now() - start, groups * 4, iterations);
+
+    if (out32 != v32)
+    {
+        abort();
+    }
+
+    if (out != v)
+    {
+        abort();
+    }
+
+    sink = total;
+}
+
+} // namespace
+
+int
+main(int argc, const char* argv[])
+{
+    size_t values = argc > 1 ? strtoul(argv[1], NULL, 10) : 65536;
+    unsigned iterations = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+
+    if (argc > 3 || values == 0 || iterations == 0)
+    {
+        fprintf(stderr, "usage: %s [values [iterations]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint64_t> uniform(values);
+    std::vector<uint64_t> skewed(values);
+    uint64_t s = 88172645463325252ULL;
+
+    for (size_t i = 0; i < values; ++i)
+    {
+        const uint64_t x = xorshift(&s);
+        // every bit length equally likely
+        uniform[i] = x >> (x % 64);
+        // eight in ten fit in a byte; the rest are up to 24 bits
+        skewed[i] = x % 10 < 8 ? x % 128 : x >> (40 + x % 24);
+    }
+
+    run("uniform", uniform, iterations);
+    run("skewed", skewed, iterations);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <assert.h>
+#include <stdint.h>
+
+// POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+
+// STL
+#include <algorithm>
+
+// e
+#include "e/atomic.h"
+#include "e/block_source.h"
+
+using e::block_source;
+using e::mmap_block_source;
+
+namespace
+{
+
+class malloc_block_source : public block_source
+{
+    public:
+        malloc_block_source() {}
+        virtual ~malloc_block_source() throw () {}
+
+    public:
+        virtual unsigned char* allocate(size_t* sz, size_t align);
+        virtual void release(unsigned char* ptr, size_t sz);
+};
+
+unsigned char*
+malloc_block_source :: allocate(size_t* sz, size_t align)
+{
+    void* tmp = NULL;
+
+    if (align > sizeof(void*))
+    {
+        if (posix_memalign(&tmp, align, *sz) != 0)
+        {
+            tmp = NULL;
+        }
+    }
+    else
+    {
+        tmp = malloc(*sz);
+    }
+
+    return static_cast<unsigned char*>(tmp);
+}
+
+void
+malloc_block_source :: release(unsigned char* ptr, size_t)
+{
+    free(ptr);
+}
+
+inline size_t
+round_up(size_t sz, size_t multiple)
+{
+    return (sz + multiple - 1) & ~(multiple - 1);
+}
+
+} // namespace
+
+block_source*
+block_source :: malloc_source()
+{
+    static malloc_block_source s;
+    return &s;
+}
+
+block_source :: block_source()
+{
+}
+
+block_source :: ~block_source() throw ()
+{
+}
+
+mmap_block_source :: mmap_block_source(bool huge_pages)
+    : m_huge_pages(huge_pages)
+    , m_page_size(sysconf(_SC_PAGESIZE))
+    , m_huge_page_blocks(0)
+{
+}
+
+mmap_block_source :: ~mmap_block_source() throw ()
+{
+}
+
+unsigned char*
+mmap_block_source :: allocate(size_t* sz, size_t align)
+{
+    const size_t granule = m_huge_pages ? HUGE_PAGE_SIZE : m_page_size;
+    align = std::max(align, granule);
+    const size_t len = round_up(*sz, granule);
+    // mmap only promises page alignment, so over-map by the alignment and
+    // unmap whatever falls outside the aligned range
+    const size_t slop = align > m_page_size ? align : 0;
+    void* tmp = mmap(NULL, len + slop, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (tmp == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    unsigned char* base = static_cast<unsigned char*>(tmp);
+    unsigned char* ptr = base;
+
+    if (slop)
+    {
+        const uintptr_t p = reinterpret_cast<uintptr_t>(base);
+        ptr = reinterpret_cast<unsigned char*>((p + align - 1) & ~(uintptr_t(align) - 1));
+        const size_t head = ptr - base;
+        const size_t tail = slop - head;
+
+        if (head)
+        {
+            munmap(base, head);
+        }
+
+        if (tail)
+        {
+            munmap(ptr + len, tail);
+        }
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (m_huge_pages && madvise(ptr, len, MADV_HUGEPAGE) == 0)
+    {
+        e::atomic::increment_64_nobarrier(&m_huge_page_blocks, 1);
+    }
+#endif
+
+    *sz = len;
+    return ptr;
+}
+
+void
+mmap_block_source :: release(unsigned char* ptr, size_t sz)
+{
+    int rc = munmap(ptr, sz);
+    assert(rc == 0);
+    (void) rc;
+}
+
+uint64_t
+mmap_block_source :: huge_page_blocks() const
+{
+    return e::atomic::load_64_nobarrier(&m_huge_page_blocks);
+}
@@ -25,46 +25,62 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 // C
 #include <stddef.h>
 
 // STL
+#include <algorithm>
 #include <memory>
 
 // e
+#include "e/atomic.h"
 #include "e/buffer.h"
+#include "e/buffer_pool.h"
+#include "alloc_counters.h"
 
 using e::buffer;
+using e::buffer_pool;
 
 void*
 buffer :: operator new (size_t, size_t num)
 {
-    return new char[offsetof(buffer, m_data) + num];
+    // the constructor value-initializes m_data[0], so never go below
+    // sizeof(buffer) even for an empty buffer
+    return buffer_pool::allocate(std::max(sizeof(buffer), offsetof(buffer, m_data) + num));
 }
 
 void
 buffer :: operator delete (void* mem)
 {
-    delete[] static_cast<char*>(mem);
+    buffer_pool::release(mem);
 }
 
 buffer :: buffer(size_t sz)
-    : m_cap(sz)
+    : m_ref(0)
+    , m_cap(sz)
     , m_size(0)
     , m_data()
 {
+    E_ALLOC_STAT(alloc_counters::buffer_create(m_cap));
 }
 
 buffer :: buffer(const char* buf, size_t sz)
-    : m_cap(sz)
+    : m_ref(0)
+    , m_cap(sz)
     , m_size(sz)
     , m_data()
 {
     memmove(m_data, buf, sz);
+    E_ALLOC_STAT(alloc_counters::buffer_create(m_cap));
 }
 
 buffer :: ~buffer() throw ()
 {
+    E_ALLOC_STAT(alloc_counters::buffer_destroy(m_cap));
 }
 
 bool
@@ -82,9 +98,8 @@ buffer*
 buffer :: copy() const
 {
     std::auto_ptr<buffer> ret(create(m_cap));
-    ret->m_cap = m_cap;
     ret->m_size = m_size;
-    memmove(ret->m_data, m_data, m_cap);
+    memmove(ret->m_data, m_data, m_size);
     return ret.release();
 }
 
@@ -95,6 +110,34 @@ buffer :: resize(size_t sz)
     m_size = sz;
 }
 
+void
+buffer :: reserve(buffer** buf, size_t sz)
+{
+    if ((*buf)->m_cap >= sz)
+    {
+        return;
+    }
+
+    buffer* tmp = create(sz);
+    tmp->m_size = (*buf)->m_size;
+    memmove(tmp->m_data, (*buf)->m_data, (*buf)->m_size);
+    delete *buf;
+    *buf = tmp;
+}
+
+void
+buffer :: shrink_to_fit(buffer** buf)
+{
+    if ((*buf)->m_cap == (*buf)->m_size)
+    {
+        return;
+    }
+
+    buffer* tmp = create((*buf)->cdata(), (*buf)->m_size);
+    delete *buf;
+    *buf = tmp;
+}
+
 e::packer
 buffer :: pack()
 {
@@ -107,6 +150,18 @@ buffer :: pack_at(size_t off)
     return packer(this, off);
 }
 
+e::packer
+buffer :: pack_growable(buffer** buf)
+{
+    return pack_growable_at(buf, 0);
+}
+
+e::packer
+buffer :: pack_growable_at(buffer** buf, size_t off)
+{
+    return packer(buf, off);
+}
+
 e::unpacker
 buffer :: unpack()
 {
@@ -123,3 +178,24 @@ buffer :: unpack_from(size_t off)
 
     return e::unpacker(m_data + off, m_size - off);
 }
+
+void
+buffer :: inc()
+{
+    e::atomic::increment_32_fullbarrier(&m_ref, 1);
+}
+
+void
+buffer :: dec()
+{
+    if (e::atomic::increment_32_fullbarrier(&m_ref, -1) == 0)
+    {
+        delete this;
+    }
+}
+
+bool
+buffer :: shared() const
+{
+    return e::atomic::load_32_acquire(&m_ref) > 1;
+}
@@ -0,0 +1,327 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define __STDC_LIMIT_MACROS
+
+// C
+#include <assert.h>
+#include <stdint.h>
+
+// e
+#include "e/buffer_chain.h"
+
+using e::buffer_chain;
+using e::chain_unpacker;
+
+namespace
+{
+
+// References below this size are copied into an owned chunk.
+const size_t MIN_REFERENCE = 256;
+// Owned chunks allocated by the chain grow geometrically between these.
+const size_t MIN_CHUNK = 512;
+const size_t MAX_CHUNK = 65536;
+
+struct chain_bytes_manager : public e::packer::bytes_manager
+{
+    chain_bytes_manager(buffer_chain* chain) : m_chain(chain) {}
+    virtual ~chain_bytes_manager() throw () {}
+
+    virtual void write(size_t off, const uint8_t* ptr, size_t ptr_sz)
+    {
+        if (off != m_chain->size())
+        {
+            abort();
+        }
+
+        m_chain->append_copy(ptr, ptr_sz);
+    }
+
+    virtual void reference(size_t off, const uint8_t* ptr, size_t ptr_sz)
+    {
+        if (off != m_chain->size())
+        {
+            abort();
+        }
+
+        m_chain->append_reference(ptr, ptr_sz);
+    }
+
+    private:
+        buffer_chain* m_chain;
+
+    private:
+        chain_bytes_manager(const chain_bytes_manager&);
+        chain_bytes_manager& operator = (const chain_bytes_manager&);
+};
+
+} // namespace
+
+buffer_chain :: buffer_chain()
+    : m_chunks()
+    , m_size(0)
+{
+}
+
+buffer_chain :: ~buffer_chain() throw ()
+{
+    clear();
+}
+
+e::slice
+buffer_chain :: chunk(size_t idx) const
+{
+    assert(idx < m_chunks.size());
+    return e::slice(m_chunks[idx].data, m_chunks[idx].size);
+}
+
+std::string
+buffer_chain :: str() const
+{
+    std::string s;
+    s.reserve(m_size);
+
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        s.append(reinterpret_cast<const char*>(m_chunks[i].data), m_chunks[i].size);
+    }
+
+    return s;
+}
+
+void
+buffer_chain :: append(e::buffer* buf)
+{
+    m_chunks.push_back(chunk_t(buf->data(), buf->size(), buf));
+    m_size += buf->size();
+}
+
+void
+buffer_chain :: append_copy(const uint8_t* data, size_t sz)
+{
+    while (sz > 0)
+    {
+        reserve_tail();
+        chunk_t* c = &m_chunks.back();
+        const size_t amt = std::min(sz, c->owned->capacity() - c->owned->size());
+        memmove(c->owned->end(), data, amt);
+        c->owned->resize(c->owned->size() + amt);
+        c->size += amt;
+        m_size += amt;
+        data += amt;
+        sz -= amt;
+    }
+}
+
+void
+buffer_chain :: append_reference(const uint8_t* data, size_t sz)
+{
+    if (sz < MIN_REFERENCE)
+    {
+        return append_copy(data, sz);
+    }
+
+    m_chunks.push_back(chunk_t(data, sz, NULL));
+    m_size += sz;
+}
+
+void
+buffer_chain :: clear()
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        if (m_chunks[i].owned)
+        {
+            delete m_chunks[i].owned;
+        }
+    }
+
+    m_chunks.clear();
+    m_size = 0;
+}
+
+e::packer
+buffer_chain :: pack()
+{
+    return e::packer(new chain_bytes_manager(this), m_size);
+}
+
+chain_unpacker
+buffer_chain :: unpack() const
+{
+    return chain_unpacker(this);
+}
+
+void
+buffer_chain :: to_iovec(std::vector<iovec>* iov) const
+{
+    iov->reserve(iov->size() + m_chunks.size());
+
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        if (m_chunks[i].size == 0)
+        {
+            continue;
+        }
+
+        iovec v;
+        v.iov_base = const_cast<uint8_t*>(m_chunks[i].data);
+        v.iov_len = m_chunks[i].size;
+        iov->push_back(v);
+    }
+}
+
+void
+buffer_chain :: reserve_tail()
+{
+    if (!m_chunks.empty() &&
+        m_chunks.back().owned &&
+        m_chunks.back().owned->size() < m_chunks.back().owned->capacity())
+    {
+        return;
+    }
+
+    size_t sz = MIN_CHUNK;
+
+    for (size_t i = m_chunks.size(); i > 0; --i)
+    {
+        if (m_chunks[i - 1].owned)
+        {
+            sz = std::min(m_chunks[i - 1].owned->capacity() * 2, MAX_CHUNK);
+            sz = std::max(sz, MIN_CHUNK);
+            break;
+        }
+    }
+
+    e::buffer* buf = e::buffer::create(sz);
+    m_chunks.push_back(chunk_t(buf->data(), 0, buf));
+}
+
+chain_unpacker :: chain_unpacker(const buffer_chain* chain)
+    : m_chain(chain)
+    , m_chunk(0)
+    , m_off(0)
+    , m_remain(chain->size())
+    , m_error(false)
+    , m_scratch(new scratch_t())
+{
+    *this = advance(0);
+}
+
+chain_unpacker :: chain_unpacker(const chain_unpacker& other)
+    : m_chain(other.m_chain)
+    , m_chunk(other.m_chunk)
+    , m_off(other.m_off)
+    , m_remain(other.m_remain)
+    , m_error(other.m_error)
+    , m_scratch(other.m_scratch)
+{
+}
+
+chain_unpacker :: ~chain_unpacker() throw ()
+{
+}
+
+chain_unpacker&
+chain_unpacker :: operator = (const chain_unpacker& rhs)
+{
+    // no self assign check needed
+    m_chain = rhs.m_chain;
+    m_chunk = rhs.m_chunk;
+    m_off = rhs.m_off;
+    m_remain = rhs.m_remain;
+    m_error = rhs.m_error;
+    m_scratch = rhs.m_scratch;
+    return *this;
+}
+
+e::unpacker
+chain_unpacker :: current() const
+{
+    if (m_chunk >= m_chain->chunk_count())
+    {
+        return e::unpacker();
+    }
+
+    e::slice c = m_chain->chunk(m_chunk);
+    return e::unpacker(c.data() + m_off, c.size() - m_off);
+}
+
+e::unpacker
+chain_unpacker :: gather(size_t sz) const
+{
+    std::vector<uint8_t>* s = &m_scratch->work;
+    s->clear();
+    s->reserve(sz);
+    size_t idx = m_chunk;
+    size_t off = m_off;
+
+    while (s->size() < sz && idx < m_chain->chunk_count())
+    {
+        e::slice c = m_chain->chunk(idx);
+        const size_t amt = std::min(sz - s->size(), c.size() - off);
+        s->insert(s->end(), c.data() + off, c.data() + off + amt);
+        ++idx;
+        off = 0;
+    }
+
+    return e::unpacker(e::slice(*s));
+}
+
+void
+chain_unpacker :: keep() const
+{
+    m_scratch->kept.push_back(std::vector<uint8_t>());
+    m_scratch->kept.back().swap(m_scratch->work);
+}
+
+chain_unpacker
+chain_unpacker :: advance(size_t sz) const
+{
+    assert(sz <= m_remain);
+    chain_unpacker ret(*this);
+    ret.m_off += sz;
+    ret.m_remain -= sz;
+
+    while (ret.m_chunk < m_chain->chunk_count() &&
+           ret.m_off >= m_chain->chunk(ret.m_chunk).size() &&
+           ret.m_remain > 0)
+    {
+        ret.m_off -= m_chain->chunk(ret.m_chunk).size();
+        ++ret.m_chunk;
+    }
+
+    return ret;
+}
+
+chain_unpacker
+chain_unpacker :: error_out() const
+{
+    chain_unpacker ret(*this);
+    ret.m_error = true;
+    return ret;
+}
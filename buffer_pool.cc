@@ -0,0 +1,342 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define __STDC_LIMIT_MACROS
+
+// C
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// STL
+#include <new>
+
+// POSIX
+#include <pthread.h>
+
+// po6
+#include <po6/threads/mutex.h>
+
+// e
+#include "e/atomic.h"
+#include "e/buffer_pool.h"
+#include "e/pow2.h"
+
+using e::buffer_pool;
+
+namespace
+{
+
+// A header in front of each pooled block records its size class so that
+// release knows where to put it.  Blocks allocated while pooling is off, or
+// that are too big to pool, have no header.  Every block starts on a
+// BLOCK_ALIGN boundary, so release tells the two apart by whether the
+// pointer it gets sits HEADER_SIZE past such a boundary.
+const size_t HEADER_SIZE = sizeof(uint64_t);
+const uintptr_t BLOCK_ALIGN = 2 * HEADER_SIZE;
+const size_t NUM_CLASSES = 64;
+// The smallest class must hold the header plus a free-list link.
+const uint64_t MIN_CLASS = 4;
+
+struct thread_cache
+{
+    thread_cache();
+    ~thread_cache() throw ();
+    void flush();
+
+    void* free_lists[NUM_CLASSES];
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t retained_bytes;
+    thread_cache* prev;
+    thread_cache* next;
+
+    private:
+        thread_cache(const thread_cache&);
+        thread_cache& operator = (const thread_cache&);
+};
+
+uint64_t g_max_retained = 0;
+uint64_t g_max_block = 0;
+uint32_t g_enabled = 0;
+
+// guards g_caches and the counters of exited threads
+po6::threads::mutex g_mtx;
+thread_cache* g_caches = NULL;
+buffer_pool::stats g_exited;
+
+pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+pthread_key_t g_key;
+__thread thread_cache* t_cache = NULL;
+
+thread_cache :: thread_cache()
+    : free_lists()
+    , hits(0)
+    , misses(0)
+    , retained_bytes(0)
+    , prev(NULL)
+    , next(NULL)
+{
+}
+
+thread_cache :: ~thread_cache() throw ()
+{
+    flush();
+}
+
+void
+thread_cache :: flush()
+{
+    for (size_t i = 0; i < NUM_CLASSES; ++i)
+    {
+        while (free_lists[i])
+        {
+            void* block = free_lists[i];
+            free_lists[i] = *reinterpret_cast<void**>(static_cast<char*>(block) + HEADER_SIZE);
+            free(block);
+        }
+    }
+
+    e::atomic::store_64_nobarrier(&retained_bytes, 0);
+}
+
+void
+destroy_thread_cache(void* _tc)
+{
+    thread_cache* tc = static_cast<thread_cache*>(_tc);
+    tc->flush();
+
+    {
+        po6::threads::mutex::hold hold(&g_mtx);
+        g_exited.hits += tc->hits;
+        g_exited.misses += tc->misses;
+
+        if (tc->prev)
+        {
+            tc->prev->next = tc->next;
+        }
+        else
+        {
+            g_caches = tc->next;
+        }
+
+        if (tc->next)
+        {
+            tc->next->prev = tc->prev;
+        }
+    }
+
+    t_cache = NULL;
+    delete tc;
+}
+
+void
+create_key()
+{
+    pthread_key_create(&g_key, destroy_thread_cache);
+}
+
+thread_cache*
+get_thread_cache()
+{
+    if (t_cache)
+    {
+        return t_cache;
+    }
+
+    pthread_once(&g_key_once, create_key);
+    thread_cache* tc = new thread_cache();
+
+    {
+        po6::threads::mutex::hold hold(&g_mtx);
+        tc->next = g_caches;
+
+        if (g_caches)
+        {
+            g_caches->prev = tc;
+        }
+
+        g_caches = tc;
+    }
+
+    pthread_setspecific(g_key, tc);
+    t_cache = tc;
+    return tc;
+}
+
+// malloc, but BLOCK_ALIGN-aligned even where malloc aligns less
+void*
+aligned_block(size_t sz)
+{
+    void* block = malloc(sz);
+
+    if (block && (reinterpret_cast<uintptr_t>(block) & (BLOCK_ALIGN - 1)))
+    {
+        free(block);
+
+        if (posix_memalign(&block, BLOCK_ALIGN, sz) != 0)
+        {
+            block = NULL;
+        }
+    }
+
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+
+    return block;
+}
+
+inline bool
+has_header(const void* ptr)
+{
+    return (reinterpret_cast<uintptr_t>(ptr) & (BLOCK_ALIGN - 1)) == HEADER_SIZE;
+}
+
+inline void
+bump(uint64_t* counter, uint64_t amount)
+{
+    // only the owning thread writes; other threads read for stats
+    e::atomic::store_64_nobarrier(counter, *counter + amount);
+}
+
+} // namespace
+
+void
+buffer_pool :: enable(size_t max_retained, size_t max_block)
+{
+    e::atomic::store_64_nobarrier(&g_max_retained, max_retained);
+    e::atomic::store_64_nobarrier(&g_max_block, max_block);
+    e::atomic::store_32_release(&g_enabled, 1);
+}
+
+void
+buffer_pool :: disable()
+{
+    e::atomic::store_32_release(&g_enabled, 0);
+}
+
+bool
+buffer_pool :: enabled()
+{
+    return e::atomic::load_32_acquire(&g_enabled) != 0;
+}
+
+void
+buffer_pool :: get_stats(stats* s)
+{
+    po6::threads::mutex::hold hold(&g_mtx);
+    *s = g_exited;
+
+    for (thread_cache* tc = g_caches; tc; tc = tc->next)
+    {
+        s->hits += e::atomic::load_64_nobarrier(&tc->hits);
+        s->misses += e::atomic::load_64_nobarrier(&tc->misses);
+        s->retained_bytes += e::atomic::load_64_nobarrier(&tc->retained_bytes);
+    }
+}
+
+void
+buffer_pool :: trim()
+{
+    if (t_cache)
+    {
+        t_cache->flush();
+    }
+}
+
+void*
+buffer_pool :: allocate(size_t sz)
+{
+    const uint64_t max_block = e::atomic::load_64_nobarrier(&g_max_block);
+
+    if (enabled() && sz <= max_block && max_block - sz >= HEADER_SIZE)
+    {
+        uint64_t block_sz = e::next_pow2(sz + HEADER_SIZE);
+        uint64_t cls = __builtin_ctzll(block_sz);
+
+        if (cls < MIN_CLASS)
+        {
+            cls = MIN_CLASS;
+            block_sz = 1ULL << MIN_CLASS;
+        }
+
+        thread_cache* tc = get_thread_cache();
+        void* block = tc->free_lists[cls];
+
+        if (block)
+        {
+            tc->free_lists[cls] = *reinterpret_cast<void**>(static_cast<char*>(block) + HEADER_SIZE);
+            bump(&tc->retained_bytes, -block_sz);
+            bump(&tc->hits, 1);
+            return static_cast<char*>(block) + HEADER_SIZE;
+        }
+
+        bump(&tc->misses, 1);
+        block = aligned_block(block_sz);
+        *static_cast<uint64_t*>(block) = cls;
+        return static_cast<char*>(block) + HEADER_SIZE;
+    }
+
+    return aligned_block(sz > 0 ? sz : 1);
+}
+
+void
+buffer_pool :: release(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    if (!has_header(ptr))
+    {
+        free(ptr);
+        return;
+    }
+
+    void* block = static_cast<char*>(ptr) - HEADER_SIZE;
+    const uint64_t cls = *static_cast<uint64_t*>(block);
+
+    if (enabled())
+    {
+        assert(cls < NUM_CLASSES);
+        const uint64_t block_sz = 1ULL << cls;
+        thread_cache* tc = get_thread_cache();
+
+        if (tc->retained_bytes + block_sz <= e::atomic::load_64_nobarrier(&g_max_retained))
+        {
+            *reinterpret_cast<void**>(ptr) = tc->free_lists[cls];
+            tc->free_lists[cls] = block;
+            bump(&tc->retained_bytes, block_sz);
+            return;
+        }
+    }
+
+    free(block);
+}
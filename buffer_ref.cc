@@ -0,0 +1,113 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <assert.h>
+
+// e
+#include "e/buffer_ref.h"
+
+using e::buffer_ref;
+
+buffer_ref :: buffer_ref()
+    : m_buf()
+    , m_off(0)
+    , m_size(0)
+{
+}
+
+buffer_ref :: buffer_ref(e::buffer* buf)
+    : m_buf(buf)
+    , m_off(0)
+    , m_size(buf ? buf->size() : 0)
+{
+}
+
+buffer_ref :: buffer_ref(const buffer_ref& other)
+    : m_buf(other.m_buf)
+    , m_off(other.m_off)
+    , m_size(other.m_size)
+{
+}
+
+buffer_ref :: buffer_ref(const e::intrusive_ptr<e::buffer>& buf, size_t off, size_t sz)
+    : m_buf(buf)
+    , m_off(off)
+    , m_size(sz)
+{
+}
+
+buffer_ref :: ~buffer_ref() throw ()
+{
+}
+
+const uint8_t*
+buffer_ref :: data() const
+{
+    return m_buf ? m_buf->data() + m_off : NULL;
+}
+
+bool
+buffer_ref :: unique() const
+{
+    return !m_buf || !m_buf->shared();
+}
+
+buffer_ref
+buffer_ref :: sub(size_t off, size_t sz) const
+{
+    assert(off <= m_size);
+    assert(sz <= m_size - off);
+    return buffer_ref(m_buf, m_off + off, sz);
+}
+
+uint8_t*
+buffer_ref :: mutable_data()
+{
+    if (!m_buf)
+    {
+        return NULL;
+    }
+
+    if (m_buf->shared())
+    {
+        m_buf = e::buffer::create(m_buf->cdata() + m_off, m_size);
+        m_off = 0;
+    }
+
+    return m_buf->data() + m_off;
+}
+
+buffer_ref&
+buffer_ref :: operator = (const buffer_ref& rhs)
+{
+    // intrusive_ptr handles self-assignment
+    m_buf = rhs.m_buf;
+    m_off = rhs.m_off;
+    m_size = rhs.m_size;
+    return *this;
+}
@@ -0,0 +1,259 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <assert.h>
+
+// STL
+#include <algorithm>
+
+// e
+#include "e/atomic.h"
+#include "e/concurrent_arena.h"
+
+using e::concurrent_arena;
+
+namespace
+{
+
+const size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+const size_t DEFAULT_CHUNK_SIZE = 16 * 1024;
+
+inline size_t
+round_chunk(size_t chunk_size)
+{
+    return (chunk_size + 15) & ~size_t(15);
+}
+
+inline unsigned char*
+align_up(unsigned char* ptr, size_t align)
+{
+    const uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+    return reinterpret_cast<unsigned char*>((p + align - 1) & ~(uintptr_t(align) - 1));
+}
+
+} // namespace
+
+// The header of every malloc'd block.  It is padded to 32 bytes so that
+// chunks are as aligned as malloc's own allocations.
+struct concurrent_arena::block
+{
+    block* next;
+    uint64_t size;
+    uint64_t offset;
+    uint64_t padding;
+};
+
+concurrent_arena :: concurrent_arena()
+    : m_current(NULL)
+    , m_blocks(NULL)
+    , m_block_size(DEFAULT_BLOCK_SIZE)
+    , m_chunk_size(DEFAULT_CHUNK_SIZE)
+    , m_generation(0)
+{
+}
+
+concurrent_arena :: concurrent_arena(size_t block_size, size_t chunk_size)
+    : m_current(NULL)
+    , m_blocks(NULL)
+    , m_block_size(std::max(block_size, round_chunk(chunk_size)))
+    , m_chunk_size(round_chunk(chunk_size))
+    , m_generation(0)
+{
+}
+
+concurrent_arena :: ~concurrent_arena() throw ()
+{
+    clear();
+}
+
+void
+concurrent_arena :: clear()
+{
+    block* b = m_blocks;
+
+    while (b)
+    {
+        block* tmp = b->next;
+        free(b);
+        b = tmp;
+    }
+
+    m_current = NULL;
+    m_blocks = NULL;
+    // regions drop the chunks they cached from the freed blocks
+    ++m_generation;
+}
+
+bool
+concurrent_arena :: acquire_chunk(unsigned char** start, unsigned char** limit)
+{
+    // a fresh block must fit a chunk or the loop below never ends
+    if (m_chunk_size > m_block_size)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        block* b = e::atomic::load_ptr_acquire(&m_current);
+
+        if (b)
+        {
+            const uint64_t end = e::atomic::increment_64_nobarrier(&b->offset, m_chunk_size);
+
+            if (end <= b->size)
+            {
+                unsigned char* data = reinterpret_cast<unsigned char*>(b) + sizeof(block);
+                *start = data + end - m_chunk_size;
+                *limit = data + end;
+                return true;
+            }
+        }
+
+        // the current block is exhausted; race to install a fresh one
+        block* nb = new_block(m_block_size);
+
+        if (!nb)
+        {
+            return false;
+        }
+
+        if (e::atomic::compare_and_swap_ptr_release(&m_current, b, nb) == b)
+        {
+            retain(nb);
+        }
+        else
+        {
+            free(nb);
+        }
+    }
+}
+
+void
+concurrent_arena :: allocate_large(size_t sz, size_t align, unsigned char** ptr)
+{
+    block* b = new_block(sz + align - 1);
+
+    if (!b)
+    {
+        *ptr = NULL;
+        return;
+    }
+
+    retain(b);
+    *ptr = align_up(reinterpret_cast<unsigned char*>(b) + sizeof(block), align);
+}
+
+concurrent_arena::block*
+concurrent_arena :: new_block(size_t sz)
+{
+    block* b = static_cast<block*>(malloc(sizeof(block) + sz));
+
+    if (b)
+    {
+        b->next = NULL;
+        b->size = sz;
+        b->offset = 0;
+    }
+
+    return b;
+}
+
+void
+concurrent_arena :: retain(block* b)
+{
+    block* head;
+
+    do
+    {
+        head = e::atomic::load_ptr_acquire(&m_blocks);
+        b->next = head;
+    }
+    while (e::atomic::compare_and_swap_ptr_release(&m_blocks, head, b) != head);
+}
+
+concurrent_arena :: region :: region(concurrent_arena* ca)
+    : m_arena(ca)
+    , m_start(NULL)
+    , m_limit(NULL)
+    , m_generation(ca->m_generation)
+{
+}
+
+concurrent_arena :: region :: ~region() throw ()
+{
+}
+
+void
+concurrent_arena :: region :: allocate(size_t sz, char** ptr)
+{
+    allocate(sz, reinterpret_cast<unsigned char**>(ptr));
+}
+
+void
+concurrent_arena :: region :: allocate(size_t sz, unsigned char** ptr)
+{
+    allocate_aligned(sz, 1, ptr);
+}
+
+void
+concurrent_arena :: region :: allocate_aligned(size_t sz, size_t align, unsigned char** ptr)
+{
+    assert(align > 0 && (align & (align - 1)) == 0);
+
+    if (m_start && m_generation == m_arena->m_generation)
+    {
+        unsigned char* aligned = align_up(m_start, align);
+
+        if (aligned <= m_limit && sz <= size_t(m_limit - aligned))
+        {
+            *ptr = aligned;
+            m_start = aligned + sz;
+            return;
+        }
+    }
+
+    // anything over half a chunk would waste too much of a fresh chunk
+    if (sz + align - 1 > m_arena->m_chunk_size / 2)
+    {
+        m_arena->allocate_large(sz, align, ptr);
+        return;
+    }
+
+    m_generation = m_arena->m_generation;
+
+    if (!m_arena->acquire_chunk(&m_start, &m_limit))
+    {
+        m_start = m_limit = NULL;
+        *ptr = NULL;
+        return;
+    }
+
+    *ptr = align_up(m_start, align);
+    m_start = *ptr + sz;
+}
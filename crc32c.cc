@@ -0,0 +1,187 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define E_CRC32C_X86
+#include <nmmintrin.h>
+#endif
+
+// e
+#include "e/crc32c.h"
+
+namespace
+{
+
+// reflected Castagnoli polynomial
+const uint32_t POLY = 0x82f63b78;
+
+struct tables
+{
+    tables();
+    uint32_t t[8][256];
+};
+
+tables :: tables()
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            crc = (crc >> 1) ^ (-(crc & 1) & POLY);
+        }
+
+        t[0][i] = crc;
+    }
+
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        for (unsigned k = 1; k < 8; ++k)
+        {
+            t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+        }
+    }
+}
+
+const tables T;
+
+// crc is the raw register, without the pre- and post-inversion
+uint32_t
+sliced(uint32_t crc, const uint8_t* data, size_t sz)
+{
+    while (sz > 0 && (reinterpret_cast<uintptr_t>(data) & 7))
+    {
+        crc = (crc >> 8) ^ T.t[0][(crc ^ *data) & 0xff];
+        ++data;
+        --sz;
+    }
+
+    while (sz >= 8)
+    {
+        uint32_t lo;
+        uint32_t hi;
+        memcpy(&lo, data, 4);
+        memcpy(&hi, data + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc = T.t[7][lo & 0xff] ^ T.t[6][(lo >> 8) & 0xff]
+            ^ T.t[5][(lo >> 16) & 0xff] ^ T.t[4][lo >> 24]
+            ^ T.t[3][hi & 0xff] ^ T.t[2][(hi >> 8) & 0xff]
+            ^ T.t[1][(hi >> 16) & 0xff] ^ T.t[0][hi >> 24];
+        data += 8;
+        sz -= 8;
+    }
+
+    while (sz > 0)
+    {
+        crc = (crc >> 8) ^ T.t[0][(crc ^ *data) & 0xff];
+        ++data;
+        --sz;
+    }
+
+    return crc;
+}
+
+#ifdef E_CRC32C_X86
+__attribute__ ((target ("sse4.2")))
+uint32_t
+hardware(uint32_t crc, const uint8_t* data, size_t sz)
+{
+    uint64_t c = crc;
+
+    while (sz > 0 && (reinterpret_cast<uintptr_t>(data) & 7))
+    {
+        c = _mm_crc32_u8(c, *data);
+        ++data;
+        --sz;
+    }
+
+    while (sz >= 8)
+    {
+        uint64_t x;
+        memcpy(&x, data, 8);
+        c = _mm_crc32_u64(c, x);
+        data += 8;
+        sz -= 8;
+    }
+
+    while (sz > 0)
+    {
+        c = _mm_crc32_u8(c, *data);
+        ++data;
+        --sz;
+    }
+
+    return c;
+}
+
+typedef uint32_t (*crc_kernel)(uint32_t crc, const uint8_t* data, size_t sz);
+
+crc_kernel
+select_kernel()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") ? hardware : sliced;
+}
+
+// NULL until static initialization runs, which just means the tables
+const crc_kernel kernel = select_kernel();
+#endif // E_CRC32C_X86
+
+} // namespace
+
+uint32_t
+e :: crc32c(const uint8_t* data, size_t sz)
+{
+    return crc32c(0, data, sz);
+}
+
+uint32_t
+e :: crc32c(uint32_t crc, const uint8_t* data, size_t sz)
+{
+#ifdef E_CRC32C_X86
+    if (kernel)
+    {
+        return ~kernel(~crc, data, sz);
+    }
+#endif
+
+    return ~sliced(~crc, data, sz);
+}
+
+uint32_t
+e :: crc32c_portable(uint32_t crc, const uint8_t* data, size_t sz)
+{
+    return ~sliced(~crc, data, sz);
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_alloc_stats_h_
+#define e_alloc_stats_h_
+
+// C
+#include <stdint.h>
+
+// C++
+#include <iostream>
+
+namespace e
+{
+
+// Counters describing the memory held by e::arena and e::buffer.  They are
+// maintained only when libe is configured with --enable-alloc-stats;
+// otherwise the bookkeeping is compiled out and every counter reads zero.
+bool alloc_stats_enabled();
+
+struct arena_stats
+{
+    arena_stats();
+    // bytes asked of allocate, allocate_aligned and create
+    uint64_t bytes_requested;
+    // bytes currently held in blocks and large allocations
+    uint64_t bytes_reserved;
+    uint64_t blocks;
+    uint64_t large_objects;
+    // bytes skipped for alignment or abandoned at the end of a block
+    uint64_t bytes_wasted;
+    // the largest bytes_reserved has been
+    uint64_t high_water;
+};
+
+struct buffer_stats
+{
+    buffer_stats();
+    uint64_t buffers_created;
+    uint64_t buffers_live;
+    // the capacity of all live buffers
+    uint64_t bytes_live;
+    // the largest bytes_live has been
+    uint64_t high_water;
+};
+
+// Process-wide totals.  Reserved bytes, blocks and large objects are live
+// values.  Requested and wasted bytes are added when an arena is cleared
+// or destroyed, so arenas still in use are not included.
+void global_arena_stats(arena_stats* s);
+void global_buffer_stats(buffer_stats* s);
+
+std::ostream&
+operator << (std::ostream& lhs, const arena_stats& rhs);
+std::ostream&
+operator << (std::ostream& lhs, const buffer_stats& rhs);
+
+} // namespace e
+
+#endif // e_alloc_stats_h_
@@ -29,45 +29,217 @@
 #define e_arena_h_
 
 // C
+#include <stdint.h>
 #include <stdlib.h>
 
 // STL
+#include <new>
 #include <vector>
 
+// e
+#include <e/alloc_stats.h>
+#include <e/block_source.h>
+
 namespace e
 {
 class buffer;
 
+// Bump-pointer allocation out of blocks that grow geometrically from the
+// initial block size up to the maximum block size.  Allocations larger than
+// a quarter of the maximum block size get their own allocation so that they
+// do not waste the remainder of a block.  Everything is freed when the arena
+// is cleared or destroyed.  Allocation failure yields a NULL pointer.
+//
+// An arena may be recycled between requests with reset(), which releases
+// everything allocated but keeps the blocks for reuse.  mark() and rewind()
+// do the same for everything allocated since the mark; rewinds must happen
+// in the reverse order of the marks they go back to.
+//
+// create<T>() constructs objects in the arena.  Objects with non-trivial
+// destructors are destroyed in reverse order of construction when they are
+// rewound, reset, or cleared; trivially destructible objects cost nothing
+// beyond their storage.
+//
+// Blocks and large allocations come from a block_source, malloc unless one
+// is given; see e/block_source.h for an mmap-backed source that can use huge
+// pages.
 class arena
 {
+    public:
+        class savepoint;
+
     public:
         arena();
+        arena(size_t initial_block, size_t max_block);
+        arena(size_t initial_block, size_t max_block, block_source* source);
         ~arena();
 
     public:
+        // Ensure the next sz bytes of allocation come from one block.
         void reserve(size_t sz);
         void allocate(size_t sz, char** ptr);
         void allocate(size_t sz, unsigned char** ptr);
+        // align must be a power of two
+        void allocate_aligned(size_t sz, size_t align, unsigned char** ptr);
+        // Grow the most recent allocation in place from old_sz to new_sz
+        // bytes.  Fails if ptr is not the most recent allocation or the
+        // current block has no room, in which case nothing changes.
+        bool extend(unsigned char* ptr, size_t old_sz, size_t new_sz);
         void takeover(char* ptr);
         void takeover(unsigned char* ptr);
         void takeover(void* ptr);
         void takeover(e::buffer* buf);
+
+    public:
+        template <typename T> T* create();
+        template <typename T, typename A1> T* create(const A1& a1);
+        template <typename T, typename A1, typename A2>
+        T* create(const A1& a1, const A2& a2);
+        template <typename T, typename A1, typename A2, typename A3>
+        T* create(const A1& a1, const A2& a2, const A3& a3);
+        template <typename T, typename A1, typename A2, typename A3, typename A4>
+        T* create(const A1& a1, const A2& a2, const A3& a3, const A4& a4);
+
+    public:
+        savepoint mark() const;
+        void rewind(const savepoint& sp);
+        void reset();
         void clear();
+        void stats(arena_stats* s) const;
 
     private:
         arena(const arena&);
         arena& operator = (const arena&);
 
     private:
-        void raw_allocate(size_t sz, unsigned char** ptr);
+        struct block
+        {
+            block() : base(NULL), size(0) {}
+            block(unsigned char* b, size_t s) : base(b), size(s) {}
+            unsigned char* base;
+            size_t size;
+        };
+        struct destructor
+        {
+            destructor() : func(NULL), ptr(NULL) {}
+            destructor(void (*f)(void*), void* p) : func(f), ptr(p) {}
+            void (*func)(void*);
+            void* ptr;
+        };
+        template <typename T> static void destroy(void* ptr) { static_cast<T*>(ptr)->~T(); }
+        template <typename T> void* prepare();
+        template <typename T> T* finish(T* t);
+        bool is_large(size_t sz) const { return sz > m_max_block / 4; }
+        bool new_block(size_t sz);
+        void raw_allocate(size_t sz, size_t align, unsigned char** ptr);
 
     private:
+        block_source* m_source;
+        // m_blocks[m_next] is the next retained block to bump into
+        std::vector<block> m_blocks;
+        size_t m_next;
+        std::vector<block> m_large;
         std::vector<unsigned char*> m_to_free;
         std::vector<e::buffer*> m_buffers;
+        std::vector<destructor> m_destructors;
+        size_t m_next_block;
+        size_t m_max_block;
+        unsigned char* m_start;
+        unsigned char* m_limit;
+        // maintained only with --enable-alloc-stats
+        uint64_t m_requested;
+        uint64_t m_reserved;
+        uint64_t m_wasted;
+        uint64_t m_high_water;
+};
+
+class arena::savepoint
+{
+    public:
+        savepoint()
+            : m_next(0), m_start(NULL), m_limit(NULL)
+            , m_large(0), m_to_free(0), m_buffers(0), m_destructors(0) {}
+        ~savepoint() throw () {}
+
+    private:
+        friend class arena;
+        size_t m_next;
         unsigned char* m_start;
         unsigned char* m_limit;
+        size_t m_large;
+        size_t m_to_free;
+        size_t m_buffers;
+        size_t m_destructors;
 };
 
+template <typename T>
+void*
+arena :: prepare()
+{
+    if (!__has_trivial_destructor(T))
+    {
+        // reserve now so registering the destructor cannot throw after T
+        // is constructed
+        m_destructors.reserve(m_destructors.size() + 1);
+    }
+
+    unsigned char* ptr = NULL;
+    allocate_aligned(sizeof(T), __alignof__(T), &ptr);
+    return ptr;
+}
+
+template <typename T>
+T*
+arena :: finish(T* t)
+{
+    if (!__has_trivial_destructor(T))
+    {
+        m_destructors.push_back(destructor(&arena::destroy<T>, t));
+    }
+
+    return t;
+}
+
+template <typename T>
+T*
+arena :: create()
+{
+    void* ptr = prepare<T>();
+    return ptr ? finish(new (ptr) T()) : NULL;
+}
+
+template <typename T, typename A1>
+T*
+arena :: create(const A1& a1)
+{
+    void* ptr = prepare<T>();
+    return ptr ? finish(new (ptr) T(a1)) : NULL;
+}
+
+template <typename T, typename A1, typename A2>
+T*
+arena :: create(const A1& a1, const A2& a2)
+{
+    void* ptr = prepare<T>();
+    return ptr ? finish(new (ptr) T(a1, a2)) : NULL;
+}
+
+template <typename T, typename A1, typename A2, typename A3>
+T*
+arena :: create(const A1& a1, const A2& a2, const A3& a3)
+{
+    void* ptr = prepare<T>();
+    return ptr ? finish(new (ptr) T(a1, a2, a3)) : NULL;
+}
+
+template <typename T, typename A1, typename A2, typename A3, typename A4>
+T*
+arena :: create(const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+{
+    void* ptr = prepare<T>();
+    return ptr ? finish(new (ptr) T(a1, a2, a3, a4)) : NULL;
+}
+
 } // namespace e
 
 #endif // e_arena_h_
@@ -0,0 +1,105 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_arena_bytes_h_
+#define e_arena_bytes_h_
+
+// C
+#include <stdint.h>
+
+// e
+#include <e/arena.h>
+#include <e/basic_packer.h>
+#include <e/serialization.h>
+#include <e/slice.h>
+
+namespace e
+{
+
+// A packer destination in an e::arena, for encoding keys and values that live
+// only as long as the request that builds them.  The bytes grow in place while
+// they are the arena's most recent allocation and are copied to a larger
+// allocation otherwise; either way, growing costs no heap allocation unless
+// the arena needs a new block.  Slices stay valid until the arena is rewound
+// past them, reset, or cleared, even if the arena_bytes is destroyed first.
+//
+// Packers from pack() refer to this object and must not outlive it.  Running
+// the arena out of memory aborts, as overflowing a fixed e::buffer does.
+class arena_bytes : private packer::bytes_manager
+{
+    public:
+        arena_bytes(arena* a);
+        ~arena_bytes() throw ();
+
+    public:
+        const uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+        size_t capacity() const { return m_cap; }
+        e::slice as_slice() const { return e::slice(m_data, m_size); }
+
+    public:
+        // ensure capacity for at least sz bytes
+        void reserve(size_t sz);
+        // the sink interface for e::basic_packer
+        uint8_t* prepare(size_t off, size_t sz);
+        // pack at the end of the bytes so far
+        e::packer pack();
+        e::packer pack_at(size_t off);
+        // start over with fresh memory, leaving earlier slices intact
+        void clear();
+
+    private:
+        virtual void write(size_t off, const uint8_t* ptr, size_t ptr_sz);
+
+    private:
+        arena_bytes(const arena_bytes&);
+        arena_bytes& operator = (const arena_bytes&);
+
+    private:
+        arena* m_arena;
+        unsigned char* m_data;
+        size_t m_size;
+        size_t m_cap;
+};
+
+class arena_sink
+{
+    public:
+        arena_sink(arena_bytes* ab) : m_ab(ab) {}
+
+    public:
+        uint8_t* prepare(size_t off, size_t sz) { return m_ab->prepare(off, sz); }
+
+    private:
+        arena_bytes* m_ab;
+};
+
+typedef basic_packer<arena_sink> arena_packer;
+
+} // namespace e
+
+#endif // e_arena_bytes_h_
@@ -0,0 +1,458 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_basic_packer_h_
+#define e_basic_packer_h_
+
+// C
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// STL
+#include <algorithm>
+#include <list>
+#include <string>
+#include <vector>
+
+// e
+#include <e/buffer.h>
+#include <e/endian.h>
+#include <e/serialization.h>
+#include <e/slice.h>
+#include <e/varint.h>
+
+namespace e
+{
+
+// A packer that writes straight into its sink.  e::packer shares its
+// bytes_manager through a reference-counted pointer and makes a virtual call
+// per field; basic_packer copies as cheaply as a pointer and an offset, and
+// each field costs one inlined bounds check before it is encoded in place.
+//
+// A sink is a copyable handle to the destination with one member:
+//
+//     uint8_t* prepare(size_t off, size_t sz);
+//
+// which makes [off, off + sz) writable, grows the destination to at least
+// off + sz bytes, and returns a pointer to off.
+//
+// The built-in types, e::slice, the pack_* wrappers, and vectors, lists and
+// pairs of these are packed directly.  Any other type with an e::packer
+// operator (e.g., from E_SERIALIZATION_TRIPLET) is packed through that
+// operator without allocating, so existing encoders work unchanged.  To move
+// such a type onto the fast path, make its operator a template:
+//
+//     template <typename P> P operator << (P pa, const X& x)
+//     { return pa << x.a << x.b; }
+//
+// O is the wire byte order of fixed-width numbers.  The default, big_endian,
+// is what e::packer writes.  little_endian suits channels where both peers
+// are little-endian; read it back with e::basic_unpacker<little_endian>.
+// Little-endian packers have no e::packer fallback, because those operators
+// would write big-endian numbers, so every type they pack needs a template
+// operator.
+template <typename S, typename O = big_endian>
+class basic_packer
+{
+    public:
+        basic_packer(const S& sink, size_t off) : m_sink(sink), m_off(off) {}
+        ~basic_packer() throw () {}
+
+    public:
+        const S& sink() const { return m_sink; }
+        size_t offset() const { return m_off; }
+        // Return a pointer to the next sz bytes and move past them.
+        uint8_t* advance(size_t sz)
+        {
+            if (SIZE_MAX - m_off < sz)
+            {
+                abort();
+            }
+
+            uint8_t* ptr = m_sink.prepare(m_off, sz);
+            m_off += sz;
+            return ptr;
+        }
+        void append(const uint8_t* ptr, size_t ptr_sz)
+        {
+            if (ptr_sz > 0)
+            {
+                memmove(advance(ptr_sz), ptr, ptr_sz);
+            }
+        }
+
+    private:
+        S m_sink;
+        size_t m_off;
+};
+
+// Fixed-capacity e::buffer; overflowing it aborts, as with e::packer.
+class buffer_sink
+{
+    public:
+        buffer_sink(e::buffer* buf) : m_buf(buf) {}
+
+    public:
+        uint8_t* prepare(size_t off, size_t sz)
+        {
+            if (off > m_buf->capacity() || sz > m_buf->capacity() - off)
+            {
+                abort();
+            }
+
+            if (m_buf->size() < off + sz)
+            {
+                m_buf->resize(off + sz);
+            }
+
+            return m_buf->data() + off;
+        }
+
+    private:
+        e::buffer* m_buf;
+};
+
+// An e::buffer that is reallocated, at least doubling, when it fills.
+class growable_buffer_sink
+{
+    public:
+        growable_buffer_sink(e::buffer** buf) : m_buf(buf) {}
+
+    public:
+        uint8_t* prepare(size_t off, size_t sz)
+        {
+            const size_t end = off + sz;
+
+            if (end > (*m_buf)->capacity())
+            {
+                e::buffer::reserve(m_buf, std::max(end, 2 * (*m_buf)->capacity()));
+            }
+
+            if ((*m_buf)->size() < end)
+            {
+                (*m_buf)->resize(end);
+            }
+
+            return (*m_buf)->data() + off;
+        }
+
+    private:
+        e::buffer** m_buf;
+};
+
+class string_sink
+{
+    public:
+        string_sink(std::string* str) : m_str(str) {}
+
+    public:
+        uint8_t* prepare(size_t off, size_t sz)
+        {
+            if (m_str->size() < off + sz)
+            {
+                m_str->resize(off + sz);
+            }
+
+            return reinterpret_cast<uint8_t*>(&(*m_str)[0]) + off;
+        }
+
+    private:
+        std::string* m_str;
+};
+
+typedef basic_packer<buffer_sink> buffer_packer;
+typedef basic_packer<growable_buffer_sink> growable_buffer_packer;
+typedef basic_packer<string_sink> string_packer;
+typedef basic_packer<buffer_sink, little_endian> buffer_packer_le;
+typedef basic_packer<growable_buffer_sink, little_endian> growable_buffer_packer_le;
+typedef basic_packer<string_sink, little_endian> string_packer_le;
+
+// Lets operators written for e::packer write into a sink.
+template <typename S>
+class sink_bytes_manager : public packer::bytes_manager
+{
+    public:
+        sink_bytes_manager(const S& sink, size_t off) : m_sink(sink), m_end(off) {}
+        virtual ~sink_bytes_manager() throw () {}
+
+    public:
+        size_t end() const { return m_end; }
+        virtual void write(size_t off, const uint8_t* ptr, size_t ptr_sz)
+        {
+            if (ptr_sz > 0)
+            {
+                memmove(m_sink.prepare(off, ptr_sz), ptr, ptr_sz);
+            }
+
+            m_end = std::max(m_end, off + ptr_sz);
+        }
+        virtual uint8_t* prepare(size_t off, size_t sz)
+        {
+            m_end = std::max(m_end, off + sz);
+            return m_sink.prepare(off, sz);
+        }
+
+    private:
+        S m_sink;
+        size_t m_end;
+};
+
+// Any value with an e::packer operator.  Converting to packable is a
+// user-defined conversion, so every exact overload for basic_packer,
+// including template operators, is preferred to this fallback.
+class packable
+{
+    public:
+        template <typename T>
+        packable(const T& t) : m_ptr(&t), m_pack(&packable::thunk<T>) {}
+
+    public:
+        void pack(e::packer pa) const { m_pack(pa, m_ptr); }
+
+    private:
+        template <typename T>
+        static void thunk(e::packer pa, const void* ptr)
+        { pa << *static_cast<const T*>(ptr); }
+
+    private:
+        const void* m_ptr;
+        void (*m_pack)(e::packer pa, const void* ptr);
+};
+
+// e::packer operators write big-endian, so only big-endian packers fall back
+// to them.
+template <typename S>
+inline basic_packer<S, big_endian>
+operator << (basic_packer<S, big_endian> pa, const packable& x)
+{
+    sink_bytes_manager<S> mgr(pa.sink(), pa.offset());
+    x.pack(e::packer(mgr, pa.offset()));
+    return basic_packer<S, big_endian>(pa.sink(), mgr.end());
+}
+
+#define E_BASIC_PACKER(TYPE) \
+    template <typename S, typename O> \
+    inline basic_packer<S, O> \
+    operator << (basic_packer<S, O> pa, TYPE rhs) \
+    { \
+        O::pack(rhs, pa.advance(sizeof(TYPE))); \
+        return pa; \
+    }
+
+E_BASIC_PACKER(int8_t)
+E_BASIC_PACKER(int16_t)
+E_BASIC_PACKER(int32_t)
+E_BASIC_PACKER(int64_t)
+E_BASIC_PACKER(uint8_t)
+E_BASIC_PACKER(uint16_t)
+E_BASIC_PACKER(uint32_t)
+E_BASIC_PACKER(uint64_t)
+E_BASIC_PACKER(double)
+
+#undef E_BASIC_PACKER
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_varint& x)
+{
+    e::packvarint64(x.x, pa.advance(varint_length(x.x)));
+    return pa;
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_svarint& x)
+{
+    return pa << pack_varint(zigzag_encode(x.x));
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_svarint_array& x)
+{
+    const size_t sz = pack_size(x);
+    uint8_t* ptr = pa.advance(sz);
+    e::svarint64_encode_n(ptr, ptr + sz, x.t, x.sz);
+    return pa;
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_delta_varint& x)
+{
+    x.encode(pa.advance(pack_size(x)));
+    return pa;
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_group_varint& x)
+{
+    x.encode(pa.advance(pack_size(x)));
+    return pa;
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const e::slice& rhs)
+{
+    const size_t vsz = varint_length(rhs.size());
+    uint8_t* ptr = pa.advance(vsz + rhs.size());
+    ptr = e::packvarint64(rhs.size(), ptr);
+
+    if (rhs.size() > 0)
+    {
+        memmove(ptr, rhs.data(), rhs.size());
+    }
+
+    return pa;
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_memmove& x)
+{
+    pa.append(x.data(), x.size());
+    return pa;
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_reference& x)
+{
+    pa.append(x.data, x.size);
+    return pa;
+}
+
+template <typename S, typename O, typename T>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_array<T>& x)
+{
+    for (size_t i = 0; i < x.sz; ++i)
+    {
+        pa = pa << x.t[i];
+    }
+
+    return pa;
+}
+
+#define E_BASIC_PACKER_ARRAY(TYPE) \
+    template <typename S, typename O> \
+    inline basic_packer<S, O> \
+    operator << (basic_packer<S, O> pa, const pack_array<TYPE>& x) \
+    { \
+        if (x.sz > SIZE_MAX / sizeof(TYPE)) \
+        { \
+            abort(); \
+        } \
+        uint8_t* ptr = pa.advance(x.sz * sizeof(TYPE)); \
+        if (x.sz > 0) \
+        { \
+            O::pack(x.t, x.sz, ptr); \
+        } \
+        return pa; \
+    }
+
+E_BASIC_PACKER_ARRAY(int16_t)
+E_BASIC_PACKER_ARRAY(int32_t)
+E_BASIC_PACKER_ARRAY(int64_t)
+E_BASIC_PACKER_ARRAY(uint16_t)
+E_BASIC_PACKER_ARRAY(uint32_t)
+E_BASIC_PACKER_ARRAY(uint64_t)
+E_BASIC_PACKER_ARRAY(double)
+
+#undef E_BASIC_PACKER_ARRAY
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_array<uint8_t>& x)
+{
+    pa.append(x.t, x.sz);
+    return pa;
+}
+
+template <typename S, typename O>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_array<int8_t>& x)
+{
+    pa.append(reinterpret_cast<const uint8_t*>(x.t), x.sz);
+    return pa;
+}
+
+template <typename S, typename O, typename T>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_uint8<T>& x)
+{
+    return pa << static_cast<uint8_t>(x.t);
+}
+
+template <typename S, typename O, typename T>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const pack_uint16<T>& x)
+{
+    return pa << static_cast<uint16_t>(x.t);
+}
+
+template <typename S, typename O, typename T>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const std::vector<T>& rhs)
+{
+    pa = pa << pack_varint(rhs.size());
+
+    if (!rhs.empty())
+    {
+        pa = pa << pack_array<T>(&rhs[0], rhs.size());
+    }
+
+    return pa;
+}
+
+template <typename S, typename O, typename T>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const std::list<T>& rhs)
+{
+    pa = pa << pack_varint(rhs.size());
+
+    for (typename std::list<T>::const_iterator it = rhs.begin(); it != rhs.end(); ++it)
+    {
+        pa = pa << *it;
+    }
+
+    return pa;
+}
+
+template <typename S, typename O, typename A, typename B>
+inline basic_packer<S, O>
+operator << (basic_packer<S, O> pa, const std::pair<A, B>& rhs)
+{
+    return pa << rhs.first << rhs.second;
+}
+
+} // namespace e
+
+#endif // e_basic_packer_h_
@@ -0,0 +1,414 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_basic_unpacker_h_
+#define e_basic_unpacker_h_
+
+// C
+#include <stdint.h>
+#include <string.h>
+
+// STL
+#include <list>
+#include <vector>
+
+// e
+#include <e/endian.h>
+#include <e/serialization.h>
+#include <e/slice.h>
+#include <e/varint.h>
+
+namespace e
+{
+
+// The counterpart to e::basic_packer: an unpacker whose fixed-width numbers
+// are in byte order O.  basic_unpacker<big_endian> reads what e::packer
+// writes; basic_unpacker<little_endian> reads what a little-endian
+// basic_packer writes.
+//
+// The built-in types, e::slice, the unpack_* wrappers, and vectors, lists
+// and pairs of these are unpacked directly.  Other types need a template
+// operator:
+//
+//     template <typename U> U operator >> (U up, X& x)
+//     { return up >> x.a >> x.b; }
+//
+// As with e::unpacker, a failure sets error() and makes every later
+// operation fail.
+template <typename O>
+class basic_unpacker
+{
+    public:
+        basic_unpacker(const uint8_t* data, size_t sz)
+            : m_ptr(data), m_end(data + sz), m_error(false) {}
+        basic_unpacker(const e::slice& s)
+            : m_ptr(s.data()), m_end(s.data() + s.size()), m_error(false) {}
+        ~basic_unpacker() throw () {}
+
+    public:
+        bool error() const { return m_error; }
+        size_t remain() const { return m_end - m_ptr; }
+        e::slice remainder() const { return e::slice(m_ptr, m_end - m_ptr); }
+        const uint8_t* start() const { return m_ptr; }
+        const uint8_t* limit() const { return m_end; }
+        // Return a pointer to the next sz bytes and move past them.  If fewer
+        // remain, fail and return NULL.
+        const uint8_t* advance(size_t sz)
+        {
+            if (m_error || sz > remain())
+            {
+                fail();
+                return NULL;
+            }
+
+            const uint8_t* ptr = m_ptr;
+            m_ptr += sz;
+            return ptr;
+        }
+        void fail() { m_ptr = m_end; m_error = true; }
+
+    private:
+        const uint8_t* m_ptr;
+        const uint8_t* m_end;
+        bool m_error;
+};
+
+typedef basic_unpacker<little_endian> unpacker_le;
+
+#define E_BASIC_UNPACKER(TYPE) \
+    template <typename O> \
+    inline basic_unpacker<O> \
+    operator >> (basic_unpacker<O> up, TYPE& rhs) \
+    { \
+        const uint8_t* ptr = up.advance(sizeof(TYPE)); \
+        if (ptr) \
+        { \
+            O::unpack(ptr, &rhs); \
+        } \
+        return up; \
+    }
+
+E_BASIC_UNPACKER(int8_t)
+E_BASIC_UNPACKER(int16_t)
+E_BASIC_UNPACKER(int32_t)
+E_BASIC_UNPACKER(int64_t)
+E_BASIC_UNPACKER(uint8_t)
+E_BASIC_UNPACKER(uint16_t)
+E_BASIC_UNPACKER(uint32_t)
+E_BASIC_UNPACKER(uint64_t)
+E_BASIC_UNPACKER(double)
+
+#undef E_BASIC_UNPACKER
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_varint& x)
+{
+    if (up.error())
+    {
+        return up;
+    }
+
+    const uint8_t* ptr = varint64_decode(up.start(), up.limit(), &x.x);
+
+    if (!ptr)
+    {
+        up.fail();
+        return up;
+    }
+
+    up.advance(ptr - up.start());
+    return up;
+}
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_svarint& x)
+{
+    uint64_t v = 0;
+    up = up >> unpack_varint(v);
+    x.x = zigzag_decode(v);
+    return up;
+}
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_svarint_array& x)
+{
+    if (up.error() || x.sz == 0)
+    {
+        return up;
+    }
+
+    const uint8_t* ptr = e::svarint64_decode_n(up.start(), up.limit(), x.t, x.sz);
+
+    if (!ptr)
+    {
+        up.fail();
+        return up;
+    }
+
+    up.advance(ptr - up.start());
+    return up;
+}
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_delta_varint& x)
+{
+    if (up.error())
+    {
+        return up;
+    }
+
+    size_t short_by = 0;
+    const uint8_t* ptr = x.decode(up.start(), up.limit(), &short_by);
+
+    if (!ptr)
+    {
+        up.fail();
+        return up;
+    }
+
+    up.advance(ptr - up.start());
+    return up;
+}
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_group_varint& x)
+{
+    if (up.error())
+    {
+        return up;
+    }
+
+    size_t short_by = 0;
+    const uint8_t* ptr = x.decode(up.start(), up.limit(), &short_by);
+
+    if (!ptr)
+    {
+        up.fail();
+        return up;
+    }
+
+    up.advance(ptr - up.start());
+    return up;
+}
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, e::slice& rhs)
+{
+    uint64_t sz = 0;
+    up = up >> unpack_varint(sz);
+
+    if (up.error() || sz > up.remain())
+    {
+        up.fail();
+        return up;
+    }
+
+    rhs = e::slice(up.advance(sz), sz);
+    return up;
+}
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_memmove& x)
+{
+    const uint8_t* ptr = up.advance(x.size());
+
+    if (ptr && x.size() > 0)
+    {
+        memmove(x.data(), ptr, x.size());
+    }
+
+    return up;
+}
+
+template <typename O, typename T>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_array<T>& x)
+{
+    for (size_t i = 0; i < x.sz; ++i)
+    {
+        up = up >> x.t[i];
+    }
+
+    return up;
+}
+
+#define E_BASIC_UNPACKER_ARRAY(TYPE) \
+    template <typename O> \
+    inline basic_unpacker<O> \
+    operator >> (basic_unpacker<O> up, const unpack_array<TYPE>& x) \
+    { \
+        if (x.sz > up.remain() / sizeof(TYPE)) \
+        { \
+            up.fail(); \
+            return up; \
+        } \
+        const uint8_t* ptr = up.advance(x.sz * sizeof(TYPE)); \
+        if (ptr && x.sz > 0) \
+        { \
+            O::unpack(ptr, x.sz, x.t); \
+        } \
+        return up; \
+    }
+
+E_BASIC_UNPACKER_ARRAY(int16_t)
+E_BASIC_UNPACKER_ARRAY(int32_t)
+E_BASIC_UNPACKER_ARRAY(int64_t)
+E_BASIC_UNPACKER_ARRAY(uint16_t)
+E_BASIC_UNPACKER_ARRAY(uint32_t)
+E_BASIC_UNPACKER_ARRAY(uint64_t)
+E_BASIC_UNPACKER_ARRAY(double)
+
+#undef E_BASIC_UNPACKER_ARRAY
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_array<uint8_t>& x)
+{
+    return up >> unpack_memmove(x.t, x.sz);
+}
+
+template <typename O>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_array<int8_t>& x)
+{
+    return up >> unpack_memmove(x.t, x.sz);
+}
+
+template <typename O, typename T>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_uint8<T>& x)
+{
+    uint8_t mt = 0;
+    up = up >> mt;
+    x.t = static_cast<T>(mt);
+    return up;
+}
+
+template <typename O, typename T>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, const unpack_uint16<T>& x)
+{
+    uint16_t mt = 0;
+    up = up >> mt;
+    x.t = static_cast<T>(mt);
+    return up;
+}
+
+template <typename O, typename T>
+inline basic_unpacker<O>
+unpack_elements(basic_unpacker<O> up, std::vector<T>* v, uint64_t sz)
+{
+    for (uint64_t i = 0; i < sz && !up.error(); ++i)
+    {
+        v->push_back(T());
+        up = up >> v->back();
+    }
+
+    return up;
+}
+
+// check the count against the input before allocating for it
+#define E_BASIC_UNPACKER_ELEMENTS(TYPE) \
+    template <typename O> \
+    inline basic_unpacker<O> \
+    unpack_elements(basic_unpacker<O> up, std::vector<TYPE>* v, uint64_t sz) \
+    { \
+        if (sz > up.remain() / sizeof(TYPE)) \
+        { \
+            up.fail(); \
+            return up; \
+        } \
+        v->resize(sz); \
+        if (sz > 0) \
+        { \
+            up = up >> unpack_array<TYPE>(&(*v)[0], sz); \
+        } \
+        return up; \
+    }
+
+E_BASIC_UNPACKER_ELEMENTS(int8_t)
+E_BASIC_UNPACKER_ELEMENTS(int16_t)
+E_BASIC_UNPACKER_ELEMENTS(int32_t)
+E_BASIC_UNPACKER_ELEMENTS(int64_t)
+E_BASIC_UNPACKER_ELEMENTS(uint8_t)
+E_BASIC_UNPACKER_ELEMENTS(uint16_t)
+E_BASIC_UNPACKER_ELEMENTS(uint32_t)
+E_BASIC_UNPACKER_ELEMENTS(uint64_t)
+E_BASIC_UNPACKER_ELEMENTS(double)
+
+#undef E_BASIC_UNPACKER_ELEMENTS
+
+template <typename O, typename T>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, std::vector<T>& rhs)
+{
+    uint64_t sz = 0;
+    up = up >> unpack_varint(sz);
+
+    if (up.error())
+    {
+        return up;
+    }
+
+    rhs.clear();
+    return unpack_elements(up, &rhs, sz);
+}
+
+template <typename O, typename T>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, std::list<T>& rhs)
+{
+    uint64_t sz = 0;
+    up = up >> unpack_varint(sz);
+    rhs.clear();
+
+    for (uint64_t i = 0; i < sz && !up.error(); ++i)
+    {
+        rhs.push_back(T());
+        up = up >> rhs.back();
+    }
+
+    return up;
+}
+
+template <typename O, typename A, typename B>
+inline basic_unpacker<O>
+operator >> (basic_unpacker<O> up, std::pair<A, B>& rhs)
+{
+    return up >> rhs.first >> rhs.second;
+}
+
+} // namespace e
+
+#endif // e_basic_unpacker_h_
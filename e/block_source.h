@@ -0,0 +1,92 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_block_source_h_
+#define e_block_source_h_
+
+// C
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace e
+{
+
+// Where an e::arena gets its memory.  A source hands out blocks of at least
+// the requested size and alignment and may round the size up; the arena
+// uses every byte it is given and returns exactly that size on release.
+// Sources must outlive every arena using them.
+class block_source
+{
+    public:
+        // malloc/free; the default for every arena
+        static block_source* malloc_source();
+
+    public:
+        block_source();
+        virtual ~block_source() throw ();
+
+    public:
+        // align must be a power of two.  Returns NULL on failure, and
+        // otherwise updates *sz to the usable size of the block.
+        virtual unsigned char* allocate(size_t* sz, size_t align) = 0;
+        virtual void release(unsigned char* ptr, size_t sz) = 0;
+
+    private:
+        block_source(const block_source&);
+        block_source& operator = (const block_source&);
+};
+
+// Anonymous private mappings rounded to whole pages.  With huge_pages, blocks
+// are rounded and aligned to 2MB and advised with MADV_HUGEPAGE so that
+// transparent huge pages may back them; where the kernel has no THP support
+// the advice is refused and the blocks are ordinary pages.  Huge pages are
+// meant for arenas whose blocks are megabytes in size; smaller blocks are
+// still rounded up to 2MB.
+class mmap_block_source : public block_source
+{
+    public:
+        static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    public:
+        mmap_block_source(bool huge_pages);
+        virtual ~mmap_block_source() throw ();
+
+    public:
+        virtual unsigned char* allocate(size_t* sz, size_t align);
+        virtual void release(unsigned char* ptr, size_t sz);
+        // the number of blocks the kernel accepted MADV_HUGEPAGE for
+        uint64_t huge_page_blocks() const;
+
+    private:
+        const bool m_huge_pages;
+        const size_t m_page_size;
+        uint64_t m_huge_page_blocks;
+};
+
+} // namespace e
+
+#endif // e_block_source_h_
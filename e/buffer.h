@@ -35,12 +35,16 @@
 #include <string>
 
 // e
+#include <e/intrusive_ptr.h>
 #include <e/serialization.h>
 #include <e/slice.h>
 
 namespace e
 {
+class buffer_ref;
 
+// Buffers are allocated through e::buffer_pool, which may be enabled to
+// cache freed buffers by size class.
 class buffer
 {
     public:
@@ -71,18 +75,35 @@ class buffer
     public:
         void resize(size_t size);
 
+    public:
+        // Growable buffers are passed by pointer-to-pointer because growing
+        // a buffer may move it to a new allocation.  The old buffer is
+        // deleted, so nothing else may own or refer to *buf across a call.
+        static void reserve(e::buffer** buf, size_t sz);
+        static void shrink_to_fit(e::buffer** buf);
+
     public:
         e::packer pack();
         e::packer pack_at(size_t off);
+        static e::packer pack_growable(e::buffer** buf);
+        static e::packer pack_growable_at(e::buffer** buf, size_t off);
         e::unpacker unpack();
         e::unpacker unpack_from(size_t off);
 
     private:
+        friend class e::intrusive_ptr<buffer>;
+        friend class buffer_ref;
         void* operator new (size_t sz, size_t num);
         buffer(size_t sz);
         buffer(const char* buf, size_t sz);
+        // Reference counting for e::intrusive_ptr.  A buffer that is never
+        // handed to an intrusive_ptr may still be deleted directly.
+        void inc();
+        void dec();
+        bool shared() const;
 
     private:
+        uint32_t m_ref;
         size_t m_cap;
         size_t m_size;
         uint8_t m_data[1];
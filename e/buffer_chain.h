@@ -0,0 +1,268 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_buffer_chain_h_
+#define e_buffer_chain_h_
+
+// C
+#include <stdint.h>
+
+// POSIX
+#include <sys/uio.h>
+
+// STL
+#include <algorithm>
+#include <list>
+#include <string>
+#include <vector>
+
+// e
+#include <e/buffer.h>
+#include <e/compat.h>
+#include <e/serialization.h>
+#include <e/slice.h>
+
+namespace e
+{
+class chain_unpacker;
+
+// A sequence of chunks that together form one logical message.  Chunks are
+// either e::buffers owned by the chain or references to memory owned by the
+// caller, which must outlive the chain.  Messages built from a header plus
+// large payloads can be sent with writev without first copying the payloads
+// into one contiguous region.
+class buffer_chain
+{
+    public:
+        buffer_chain();
+        ~buffer_chain() throw ();
+
+    public:
+        bool empty() const { return m_size == 0; }
+        size_t size() const { return m_size; }
+        size_t chunk_count() const { return m_chunks.size(); }
+        e::slice chunk(size_t idx) const;
+        std::string str() const;
+
+    public:
+        // Take ownership of buf; later copies may fill its spare capacity.
+        void append(e::buffer* buf);
+        void append_copy(const uint8_t* data, size_t sz);
+        // References smaller than a few cache lines are copied instead, as
+        // an extra iovec would cost more than the copy.
+        void append_reference(const uint8_t* data, size_t sz);
+        void clear();
+
+    public:
+        // Packing is append-only: the packer must always write at the end
+        // of the chain.  e::pack_reference is appended without a copy.
+        e::packer pack();
+        chain_unpacker unpack() const;
+        // Append one iovec per chunk, suitable for writev.
+        void to_iovec(std::vector<iovec>* iov) const;
+
+    private:
+        struct chunk_t
+        {
+            chunk_t() : data(NULL), size(0), owned(NULL) {}
+            chunk_t(const uint8_t* d, size_t s, e::buffer* o) : data(d), size(s), owned(o) {}
+            chunk_t(const chunk_t& other) : data(other.data), size(other.size), owned(other.owned) {}
+            ~chunk_t() throw () {}
+            chunk_t& operator = (const chunk_t& rhs)
+            {
+                data = rhs.data;
+                size = rhs.size;
+                owned = rhs.owned;
+                return *this;
+            }
+
+            const uint8_t* data;
+            size_t size;
+            e::buffer* owned;
+        };
+        void reserve_tail();
+
+    private:
+        std::vector<chunk_t> m_chunks;
+        size_t m_size;
+
+    private:
+        buffer_chain(const buffer_chain&);
+        buffer_chain& operator = (const buffer_chain&);
+};
+
+// Whether unpacking a T copies out everything it decodes, so that nothing
+// it produces refers to the input.  Anything else, such as an e::slice, is
+// assumed to refer to the input.
+template <typename T>
+struct unpacks_by_copy
+{
+    static const bool value = false;
+};
+
+template <typename T>
+struct unpacks_by_copy<const T> : public unpacks_by_copy<T> {};
+template <typename T>
+struct unpacks_by_copy<unpack_array<T> > : public unpacks_by_copy<T> {};
+template <typename T>
+struct unpacks_by_copy<std::vector<T> > : public unpacks_by_copy<T> {};
+template <typename T>
+struct unpacks_by_copy<std::list<T> > : public unpacks_by_copy<T> {};
+
+template <typename A, typename B>
+struct unpacks_by_copy<std::pair<A, B> >
+{
+    static const bool value = unpacks_by_copy<A>::value && unpacks_by_copy<B>::value;
+};
+
+#define E_UNPACKS_BY_COPY(TYPE) \
+    template <> \
+    struct unpacks_by_copy<TYPE> \
+    { \
+        static const bool value = true; \
+    }
+
+E_UNPACKS_BY_COPY(int8_t);
+E_UNPACKS_BY_COPY(int16_t);
+E_UNPACKS_BY_COPY(int32_t);
+E_UNPACKS_BY_COPY(int64_t);
+E_UNPACKS_BY_COPY(uint8_t);
+E_UNPACKS_BY_COPY(uint16_t);
+E_UNPACKS_BY_COPY(uint32_t);
+E_UNPACKS_BY_COPY(uint64_t);
+E_UNPACKS_BY_COPY(double);
+E_UNPACKS_BY_COPY(unpack_memmove);
+E_UNPACKS_BY_COPY(unpack_varint);
+E_UNPACKS_BY_COPY(unpack_svarint);
+E_UNPACKS_BY_COPY(unpack_svarint_array);
+E_UNPACKS_BY_COPY(unpack_delta_varint);
+E_UNPACKS_BY_COPY(unpack_group_varint);
+
+#undef E_UNPACKS_BY_COPY
+
+// Unpacks from a buffer_chain.  Values that lie within one chunk are decoded
+// in place; a value that straddles a chunk boundary is decoded from a copy of
+// the bytes around the boundary.  The copy is reused for the next straddling
+// value unless what was unpacked may refer to it (see unpacks_by_copy), as
+// slices do; those copies remain valid while any copy of this chain_unpacker
+// exists.  The chain must not be modified while it is being unpacked.
+class chain_unpacker
+{
+    public:
+        chain_unpacker(const buffer_chain* chain);
+        chain_unpacker(const chain_unpacker& other);
+        ~chain_unpacker() throw ();
+
+    public:
+        bool error() const { return m_error; }
+        size_t remain() const { return m_remain; }
+
+    public:
+        chain_unpacker& operator = (const chain_unpacker& rhs);
+        template <typename T> chain_unpacker operator >> (T& t) const { return extract<T>(t); }
+        template <typename T> chain_unpacker operator >> (const T& t) const { return extract<const T>(t); }
+
+    private:
+        struct scratch_t
+        {
+            scratch_t() : work(), kept() {}
+            // the copy being decoded from; a vector, unlike a string, keeps
+            // its bytes in place when swapped
+            std::vector<uint8_t> work;
+            // copies that unpacked values may refer to
+            std::list<std::vector<uint8_t> > kept;
+        };
+        template <typename T> chain_unpacker extract(T& t) const;
+        e::unpacker current() const;
+        e::unpacker gather(size_t sz) const;
+        void keep() const;
+        chain_unpacker advance(size_t sz) const;
+        chain_unpacker error_out() const;
+
+    private:
+        const buffer_chain* m_chain;
+        size_t m_chunk;
+        size_t m_off;
+        size_t m_remain;
+        bool m_error;
+        e::compat::shared_ptr<scratch_t> m_scratch;
+};
+
+template <typename T>
+chain_unpacker
+chain_unpacker :: extract(T& t) const
+{
+    if (m_error)
+    {
+        return *this;
+    }
+
+    e::unpacker up = current();
+    e::unpacker nup = up >> t;
+
+    if (!nup.error())
+    {
+        return advance(up.remain() - nup.remain());
+    }
+
+    // Either the value straddles a boundary or it is malformed.  Retry
+    // against a contiguous copy that grows by as many bytes as the last
+    // attempt was short, or doubles when that is unknown, until it covers
+    // the rest of the chain.
+    size_t window = up.remain();
+
+    while (window < m_remain && !nup.malformed())
+    {
+        const size_t short_by = nup.shortfall();
+
+        if (short_by > m_remain - window)
+        {
+            break;
+        }
+
+        window = short_by > 0 ? window + short_by
+                              : std::min(std::max(window * 2, size_t(16)), m_remain);
+        up = gather(window);
+        nup = up >> t;
+
+        if (!nup.error())
+        {
+            if (!unpacks_by_copy<T>::value)
+            {
+                keep();
+            }
+
+            return advance(up.remain() - nup.remain());
+        }
+    }
+
+    return error_out();
+}
+
+} // namespace e
+
+#endif // e_buffer_chain_h_
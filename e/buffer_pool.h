@@ -0,0 +1,84 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_buffer_pool_h_
+#define e_buffer_pool_h_
+
+// C
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace e
+{
+
+// A thread-caching allocator behind e::buffer::create.  When enabled,
+// allocations are rounded up to a power-of-two size class and freed blocks
+// are kept on a per-thread free list for that class, so steady-state
+// create/delete traffic never reaches the global heap.  Pooling is off by
+// default; memory allocated while it is off is returned straight to the heap.
+//
+// Pooled blocks are prefixed with an 8-byte header, so pointers returned by
+// allocate are 8-byte aligned.  Blocks allocated while pooling is off, or
+// too big to pool, come straight from the heap without a header.
+class buffer_pool
+{
+    public:
+        struct stats
+        {
+            stats() : hits(0), misses(0), retained_bytes(0) {}
+            // allocations served from a thread cache
+            uint64_t hits;
+            // pooled allocations that had to go to the heap
+            uint64_t misses;
+            // bytes currently held in thread caches
+            uint64_t retained_bytes;
+        };
+
+    public:
+        // Each thread keeps at most max_retained bytes in its cache.
+        // Allocations larger than max_block bytes are never pooled.
+        static void enable(size_t max_retained, size_t max_block);
+        static void disable();
+        static bool enabled();
+        // Sums the counters of every live thread and every exited thread.
+        static void get_stats(stats* s);
+        // Return the calling thread's cached blocks to the heap.
+        static void trim();
+
+    public:
+        static void* allocate(size_t sz);
+        static void release(void* ptr);
+
+    private:
+        buffer_pool();
+        buffer_pool(const buffer_pool&);
+        buffer_pool& operator = (const buffer_pool&);
+};
+
+} // namespace e
+
+#endif // e_buffer_pool_h_
@@ -0,0 +1,80 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_buffer_ref_h_
+#define e_buffer_ref_h_
+
+// e
+#include <e/buffer.h>
+#include <e/intrusive_ptr.h>
+#include <e/slice.h>
+
+namespace e
+{
+
+// An owned view of a range of a reference-counted e::buffer.  Copying a
+// buffer_ref or taking a sub-range shares the underlying allocation; the
+// bytes are only copied when a shared buffer_ref asks for mutable data.
+//
+// Once a buffer is handed to a buffer_ref, the buffer_ref owns it and the
+// buffer must not be deleted directly.
+class buffer_ref
+{
+    public:
+        buffer_ref();
+        explicit buffer_ref(e::buffer* buf);
+        buffer_ref(const buffer_ref& other);
+        ~buffer_ref() throw ();
+
+    public:
+        bool empty() const { return m_size == 0; }
+        size_t size() const { return m_size; }
+        const uint8_t* data() const;
+        const char* cdata() const { return reinterpret_cast<const char*>(data()); }
+        e::slice as_slice() const { return e::slice(data(), m_size); }
+        e::unpacker unpack() const { return e::unpacker(data(), m_size); }
+        bool unique() const;
+        buffer_ref sub(size_t off, size_t sz) const;
+        // Copies the viewed bytes into a private buffer first if the
+        // underlying buffer is shared with another buffer_ref.
+        uint8_t* mutable_data();
+
+    public:
+        buffer_ref& operator = (const buffer_ref& rhs);
+
+    private:
+        buffer_ref(const e::intrusive_ptr<e::buffer>& buf, size_t off, size_t sz);
+
+    private:
+        e::intrusive_ptr<e::buffer> m_buf;
+        size_t m_off;
+        size_t m_size;
+};
+
+} // namespace e
+
+#endif // e_buffer_ref_h_
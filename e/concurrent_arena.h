@@ -0,0 +1,105 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_concurrent_arena_h_
+#define e_concurrent_arena_h_
+
+// C
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace e
+{
+
+// An arena that many threads may allocate from at once, e.g., the workers
+// of one request.  Each thread allocates through its own region, which
+// bump-allocates out of chunks carved from blocks shared by the arena.
+// Chunks are claimed by atomically advancing the current block's offset and
+// blocks are installed with compare-and-swap, so allocation never takes a
+// lock.  Everything is freed at once by clear() or the destructor, neither
+// of which may run concurrently with allocation.
+class concurrent_arena
+{
+    public:
+        class region;
+
+    public:
+        concurrent_arena();
+        concurrent_arena(size_t block_size, size_t chunk_size);
+        ~concurrent_arena() throw ();
+
+    public:
+        void clear();
+
+    private:
+        struct block;
+        bool acquire_chunk(unsigned char** start, unsigned char** limit);
+        void allocate_large(size_t sz, size_t align, unsigned char** ptr);
+        block* new_block(size_t sz);
+        void retain(block* b);
+
+    private:
+        block* volatile m_current;
+        block* volatile m_blocks;
+        const size_t m_block_size;
+        const size_t m_chunk_size;
+        uint64_t m_generation;
+
+    private:
+        concurrent_arena(const concurrent_arena&);
+        concurrent_arena& operator = (const concurrent_arena&);
+};
+
+// A region belongs to one thread at a time.  Memory allocated through it
+// lives until its concurrent_arena is cleared or destroyed.  A region may
+// outlive clear() and keep allocating; it then starts on a fresh chunk.
+class concurrent_arena::region
+{
+    public:
+        region(concurrent_arena* ca);
+        ~region() throw ();
+
+    public:
+        void allocate(size_t sz, char** ptr);
+        void allocate(size_t sz, unsigned char** ptr);
+        // align must be a power of two
+        void allocate_aligned(size_t sz, size_t align, unsigned char** ptr);
+
+    private:
+        concurrent_arena* m_arena;
+        unsigned char* m_start;
+        unsigned char* m_limit;
+        uint64_t m_generation;
+
+    private:
+        region(const region&);
+        region& operator = (const region&);
+};
+
+} // namespace e
+
+#endif // e_concurrent_arena_h_
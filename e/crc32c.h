@@ -0,0 +1,56 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_crc32c_h_
+#define e_crc32c_h_
+
+// C
+#include <stddef.h>
+#include <stdint.h>
+
+namespace e
+{
+
+// CRC32C (the Castagnoli polynomial, as in iSCSI and ext4).  Uses the SSE4.2
+// crc32 instruction when the CPU has it and slicing-by-8 tables otherwise.
+//
+// To checksum data that arrives in pieces, pass the result for the earlier
+// pieces as crc:
+//     crc32c(crc32c(a, a_sz), b, b_sz) == crc32c(ab, a_sz + b_sz)
+uint32_t
+crc32c(const uint8_t* data, size_t sz);
+uint32_t
+crc32c(uint32_t crc, const uint8_t* data, size_t sz);
+
+// Always the table-driven version, so that tests and benchmarks can reach it
+// on machines with SSE4.2
+uint32_t
+crc32c_portable(uint32_t crc, const uint8_t* data, size_t sz);
+
+} // namespace e
+
+#endif // e_crc32c_h_
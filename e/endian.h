@@ -29,7 +29,9 @@
 #define e_endian_h_
 
 // C
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 namespace e
 {
@@ -60,6 +62,45 @@ const uint8_t* unpackfloatle(const uint8_t* buffer, float* number);
 const uint8_t* unpackdoublebe(const uint8_t* buffer, double* number);
 const uint8_t* unpackdoublele(const uint8_t* buffer, double* number);
 
+// Convert arrays of n numbers at once, using SIMD byte shuffles where the
+// CPU has them.  The numbers and the buffer must not overlap.
+uint8_t* pack16be(const uint16_t* numbers, size_t n, uint8_t* buffer);
+uint8_t* pack16le(const uint16_t* numbers, size_t n, uint8_t* buffer);
+uint8_t* pack32be(const uint32_t* numbers, size_t n, uint8_t* buffer);
+uint8_t* pack32le(const uint32_t* numbers, size_t n, uint8_t* buffer);
+uint8_t* pack64be(const uint64_t* numbers, size_t n, uint8_t* buffer);
+uint8_t* pack64le(const uint64_t* numbers, size_t n, uint8_t* buffer);
+
+const uint8_t* unpack16be(const uint8_t* buffer, size_t n, uint16_t* numbers);
+const uint8_t* unpack16le(const uint8_t* buffer, size_t n, uint16_t* numbers);
+const uint8_t* unpack32be(const uint8_t* buffer, size_t n, uint32_t* numbers);
+const uint8_t* unpack32le(const uint8_t* buffer, size_t n, uint32_t* numbers);
+const uint8_t* unpack64be(const uint8_t* buffer, size_t n, uint64_t* numbers);
+const uint8_t* unpack64le(const uint8_t* buffer, size_t n, uint64_t* numbers);
+
+#define BULK_WRAPPER(TYPE, SZ, END) \
+    inline uint8_t* \
+    pack ## SZ ## END(const TYPE* numbers, size_t n, uint8_t* buffer) \
+    { \
+        return pack ## SZ ## END(reinterpret_cast<const uint ## SZ ## _t*>(numbers), n, buffer); \
+    } \
+    inline const uint8_t* \
+    unpack ## SZ ## END(const uint8_t* buffer, size_t n, TYPE* numbers) \
+    { \
+        return unpack ## SZ ## END(buffer, n, reinterpret_cast<uint ## SZ ## _t*>(numbers)); \
+    }
+
+BULK_WRAPPER(int16_t, 16, be)
+BULK_WRAPPER(int16_t, 16, le)
+BULK_WRAPPER(int32_t, 32, be)
+BULK_WRAPPER(int32_t, 32, le)
+BULK_WRAPPER(int64_t, 64, be)
+BULK_WRAPPER(int64_t, 64, le)
+BULK_WRAPPER(double, 64, be)
+BULK_WRAPPER(double, 64, le)
+
+#undef BULK_WRAPPER
+
 #define SIGNED_WRAPPER(SZ, END) \
     inline const uint8_t* \
     unpack ## SZ ## END(const uint8_t* buffer, int ## SZ ## _t* number) \
@@ -128,6 +169,94 @@ PACKCHAR_FLOAT_WRAPPER(double, le)
 
 #undef PACKCHAR_FLOAT_WRAPPER
 
+// Wire byte orders for e::basic_packer and e::basic_unpacker.  A field is
+// packed inline as one unaligned store, plus a bswap when the host's order
+// differs, so a little_endian field on x86 is a plain memcpy.  Arrays go to
+// the bulk conversions above.
+template <bool BIG>
+class byte_order
+{
+    public:
+#define BYTE_ORDER_SCALAR(SZ) \
+        static uint8_t* pack(uint ## SZ ## _t number, uint8_t* buffer) \
+        { \
+            number = swap(number); \
+            memcpy(buffer, &number, sizeof(number)); \
+            return buffer + sizeof(number); \
+        } \
+        static uint8_t* pack(int ## SZ ## _t number, uint8_t* buffer) \
+        { \
+            return pack(static_cast<uint ## SZ ## _t>(number), buffer); \
+        } \
+        static const uint8_t* unpack(const uint8_t* buffer, uint ## SZ ## _t* number) \
+        { \
+            memcpy(number, buffer, sizeof(*number)); \
+            *number = swap(*number); \
+            return buffer + sizeof(*number); \
+        } \
+        static const uint8_t* unpack(const uint8_t* buffer, int ## SZ ## _t* number) \
+        { \
+            uint ## SZ ## _t tmp; \
+            buffer = unpack(buffer, &tmp); \
+            *number = static_cast<int ## SZ ## _t>(tmp); \
+            return buffer; \
+        }
+        BYTE_ORDER_SCALAR(8)
+        BYTE_ORDER_SCALAR(16)
+        BYTE_ORDER_SCALAR(32)
+        BYTE_ORDER_SCALAR(64)
+#undef BYTE_ORDER_SCALAR
+        static uint8_t* pack(double number, uint8_t* buffer)
+        {
+            uint64_t tmp;
+            memcpy(&tmp, &number, sizeof(tmp));
+            return pack(tmp, buffer);
+        }
+        static const uint8_t* unpack(const uint8_t* buffer, double* number)
+        {
+            uint64_t tmp;
+            buffer = unpack(buffer, &tmp);
+            memcpy(number, &tmp, sizeof(tmp));
+            return buffer;
+        }
+
+    public:
+#define BYTE_ORDER_ARRAY(TYPE, SZ) \
+        static uint8_t* pack(const TYPE* numbers, size_t n, uint8_t* buffer) \
+        { \
+            return BIG ? pack ## SZ ## be(numbers, n, buffer) \
+                       : pack ## SZ ## le(numbers, n, buffer); \
+        } \
+        static const uint8_t* unpack(const uint8_t* buffer, size_t n, TYPE* numbers) \
+        { \
+            return BIG ? unpack ## SZ ## be(buffer, n, numbers) \
+                       : unpack ## SZ ## le(buffer, n, numbers); \
+        }
+        BYTE_ORDER_ARRAY(int16_t, 16)
+        BYTE_ORDER_ARRAY(int32_t, 32)
+        BYTE_ORDER_ARRAY(int64_t, 64)
+        BYTE_ORDER_ARRAY(uint16_t, 16)
+        BYTE_ORDER_ARRAY(uint32_t, 32)
+        BYTE_ORDER_ARRAY(uint64_t, 64)
+        BYTE_ORDER_ARRAY(double, 64)
+#undef BYTE_ORDER_ARRAY
+
+    private:
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        static bool swapped() { return !BIG; }
+#else
+        static bool swapped() { return BIG; }
+#endif
+        static uint8_t swap(uint8_t x) { return x; }
+        static uint16_t swap(uint16_t x) { return swapped() ? __builtin_bswap16(x) : x; }
+        static uint32_t swap(uint32_t x) { return swapped() ? __builtin_bswap32(x) : x; }
+        static uint64_t swap(uint64_t x) { return swapped() ? __builtin_bswap64(x) : x; }
+};
+
+// big_endian is the order of e::packer and e::unpacker
+typedef byte_order<true> big_endian;
+typedef byte_order<false> little_endian;
+
 } // namespace e
 
 #endif // e_endian_h_
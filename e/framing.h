@@ -0,0 +1,110 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_framing_h_
+#define e_framing_h_
+
+// C
+#include <stdint.h>
+
+// STL
+#include <vector>
+
+// e
+#include <e/serialization.h>
+#include <e/slice.h>
+
+namespace e
+{
+
+// A frame is a varint length followed by that many bytes of payload.  This is
+// the same encoding as a packed e::slice, so either side may use whichever is
+// more convenient.
+
+class pack_frame
+{
+    public:
+        pack_frame(const e::slice& _payload) : payload(_payload) {}
+        ~pack_frame() throw () {}
+
+    public:
+        e::slice payload;
+};
+
+e::packer
+operator << (e::packer pa, const pack_frame& f);
+inline size_t
+pack_size(const pack_frame& f)
+{
+    return varint_length(f.payload.size()) + f.payload.size();
+}
+
+// A checked frame appends the CRC32C of the payload, as four bytes in
+// big-endian order, after a regular frame.  The length covers only the
+// payload.
+class pack_checked_frame
+{
+    public:
+        pack_checked_frame(const e::slice& _payload) : payload(_payload) {}
+        ~pack_checked_frame() throw () {}
+
+    public:
+        e::slice payload;
+};
+
+e::packer
+operator << (e::packer pa, const pack_checked_frame& f);
+inline size_t
+pack_size(const pack_checked_frame& f)
+{
+    return varint_length(f.payload.size()) + f.payload.size() + sizeof(uint32_t);
+}
+
+// Scan a receive buffer and return every complete frame in one pass.  The
+// slices point into the buffer; nothing is copied.
+//
+// The scan stops at the first incomplete frame.  The frames before it are
+// appended to "frames" and "consumed" is set to the number of bytes they
+// occupy, so the caller keeps buf[consumed..] for the next read.
+//
+// A frame whose length exceeds max_frame, or whose length is not a valid
+// varint, makes the stream unrecoverable: unpack_frames returns false.  The
+// frames before it are still returned.
+bool
+unpack_frames(const e::slice& buf, uint64_t max_frame,
+              std::vector<e::slice>* frames, size_t* consumed);
+
+// As unpack_frames, for checked frames.  Each payload is verified in place
+// before it is returned, and a checksum mismatch is treated like an
+// oversized frame.
+bool
+unpack_checked_frames(const e::slice& buf, uint64_t max_frame,
+                      std::vector<e::slice>* frames, size_t* consumed);
+
+} // namespace e
+
+#endif // e_framing_h_
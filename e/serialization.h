@@ -65,17 +65,40 @@ inline uint64_t pack_size(uint64_t) { return 8; }
 
 inline uint64_t pack_size(double) { return 8; }
 
+// pack_size(x) is the number of bytes x packs into, so a destination can be
+// sized exactly before packing.  Fixed-width types and containers of them
+// reduce to constants and multiplications; any type without its own
+// pack_size is measured by packing it into a destination that only counts.
+template <typename T> size_t pack_size(const std::vector<T>& v);
+template <typename T> size_t pack_size(const std::list<T>& L);
+template <typename A, typename B> size_t pack_size(const std::pair<A, B>& p);
+template <typename T> size_t pack_size(const T& t);
+
 class packer
 {
     public:
         packer(std::string* str);
         packer(std::string* str, size_t off);
         packer(e::buffer* buf, size_t off);
+        packer(e::buffer** buf, size_t off);
         packer(const packer& other);
         ~packer() throw ();
 
+    public:
+        struct bytes_manager;
+        // Pack into a custom destination; the packer takes ownership of mgr.
+        packer(bytes_manager* mgr, size_t off);
+        // Pack into a custom destination that outlives the packer and all
+        // copies of it.  Nothing is allocated.
+        packer(bytes_manager& mgr, size_t off);
+
     public:
         void append(const uint8_t* ptr, size_t ptr_sz, packer* pa);
+        void append_reference(const uint8_t* ptr, size_t ptr_sz, packer* pa);
+        // Return the next ptr_sz bytes of the destination to be written in
+        // place and point pa past them, or return NULL and leave pa alone if
+        // the destination does not expose its memory.
+        uint8_t* append_in_place(size_t ptr_sz, packer* pa);
 
     public:
         template <typename T> packer operator << (const std::vector<T>& rhs);
@@ -87,6 +110,13 @@ class packer
             virtual ~bytes_manager() throw ();
 
             virtual void write(size_t off, const uint8_t* ptr, size_t ptr_sz) = 0;
+            // Like write, but the caller guarantees ptr outlives the
+            // destination, so it may be kept by reference instead of copied.
+            virtual void reference(size_t off, const uint8_t* ptr, size_t ptr_sz);
+            // Make [off, off + sz) writable in place and return a pointer to
+            // off, or return NULL (the default) to have bytes come through
+            // write instead.
+            virtual uint8_t* prepare(size_t off, size_t sz);
 
             private:
                 bytes_manager(const bytes_manager&);
@@ -94,10 +124,9 @@ class packer
         };
 
     private:
-        packer(e::compat::shared_ptr<bytes_manager> mgr, size_t off);
-
-    private:
-        e::compat::shared_ptr<bytes_manager> m_mgr;
+        // owns the manager, unless the manager was borrowed
+        e::compat::shared_ptr<bytes_manager> m_owner;
+        bytes_manager* m_mgr;
         size_t m_off;
 };
 
@@ -105,6 +134,10 @@ class unpacker
 {
     public:
         static unpacker error_out();
+        // An error from running out of input at least short_by bytes early.
+        static unpacker truncated_out(size_t short_by);
+        // An error that no amount of further input could avoid.
+        static unpacker malformed_out();
 
     public:
         unpacker();
@@ -117,6 +150,9 @@ class unpacker
 
     public:
         bool error() const { return m_error; }
+        bool malformed() const { return m_malformed; }
+        // after a truncated_out error, the bytes known to be missing
+        size_t shortfall() const { return m_short; }
         size_t remain() const { return m_end - m_ptr; }
         e::slice remainder() const { return e::slice(m_ptr, m_end - m_ptr); }
         const uint8_t* start() const { return m_ptr; }
@@ -132,7 +168,9 @@ class unpacker
     private:
         const uint8_t* m_ptr;
         const uint8_t* m_end;
+        size_t m_short;
         bool m_error;
+        bool m_malformed;
 };
 
 E_SERIALIZATION_TRIPLET(int8_t);
@@ -199,6 +237,25 @@ class unpack_memmove
 e::unpacker
 operator >> (e::unpacker up, const unpack_memmove& x);
 
+// Pack bytes by reference where the destination supports it (e.g.,
+// e::buffer_chain) and by copy everywhere else.  The bytes must outlive the
+// destination.
+class pack_reference
+{
+    public:
+        pack_reference(const void* _data, size_t _size)
+            : data(static_cast<const uint8_t*>(_data)), size(_size) {}
+        pack_reference(const e::slice& s) : data(s.data()), size(s.size()) {}
+        ~pack_reference() throw () {}
+
+    public:
+        const uint8_t* data;
+        size_t size;
+};
+
+e::packer
+operator << (e::packer pa, const pack_reference& x);
+
 class pack_varint
 {
     public:
@@ -225,6 +282,159 @@ class unpack_varint
 e::unpacker
 operator >> (e::unpacker up, const unpack_varint& x);
 
+// Signed values are zigzag encoded (see zigzag_encode), so that small
+// negative numbers take a byte or two instead of ten.
+class pack_svarint
+{
+    public:
+        pack_svarint(int64_t _x) : x(_x) {}
+        ~pack_svarint() throw () {}
+
+    public:
+        int64_t x;
+};
+
+e::packer
+operator << (e::packer pa, const pack_svarint& x);
+
+class unpack_svarint
+{
+    public:
+        unpack_svarint(int64_t& _x) : x(_x) {}
+        ~unpack_svarint() throw () {}
+
+    public:
+        int64_t& x;
+};
+
+e::unpacker
+operator >> (e::unpacker up, const unpack_svarint& x);
+
+// Pack sz signed values as consecutive zigzag varints, with no count; the
+// reader must know sz, as with pack_array.  Both directions go through the
+// bulk routines in e/varint.h.
+class pack_svarint_array
+{
+    public:
+        pack_svarint_array(const int64_t* _t, size_t _sz) : t(_t), sz(_sz) {}
+        ~pack_svarint_array() throw () {}
+
+    public:
+        const int64_t* t;
+        size_t sz;
+};
+
+e::packer
+operator << (e::packer pa, const pack_svarint_array& x);
+size_t
+pack_size(const pack_svarint_array& x);
+
+class unpack_svarint_array
+{
+    public:
+        unpack_svarint_array(int64_t* _t, size_t _sz) : t(_t), sz(_sz) {}
+        ~unpack_svarint_array() throw () {}
+
+    public:
+        int64_t* t;
+        size_t sz;
+};
+
+e::unpacker
+operator >> (e::unpacker up, const unpack_svarint_array& x);
+
+inline size_t pack_size(const pack_memmove& x) { return x.size(); }
+inline size_t pack_size(const pack_reference& x) { return x.size; }
+inline size_t pack_size(const pack_varint& x) { return varint_length(x.x); }
+inline size_t pack_size(const pack_svarint& x) { return varint_length(zigzag_encode(x.x)); }
+
+// Pack a sequence of uint64_t as its length followed by the difference
+// between each value and the one before it (the first is relative to zero),
+// all as varints.  Sorted ID lists shrink from eight bytes per ID to one or
+// two.  Any sequence round trips because the differences wrap, but values
+// that go down cost ten bytes apiece.
+class pack_delta_varint
+{
+    public:
+        pack_delta_varint(const uint64_t* _t, size_t _sz) : t(_t), sz(_sz) {}
+        pack_delta_varint(const std::vector<uint64_t>& v)
+            : t(v.empty() ? NULL : &v[0]), sz(v.size()) {}
+        ~pack_delta_varint() throw () {}
+
+    public:
+        // Write the pack_size(*this) bytes of the encoding to ptr.
+        uint8_t* encode(uint8_t* ptr) const;
+
+    public:
+        const uint64_t* t;
+        size_t sz;
+};
+
+e::packer
+operator << (e::packer pa, const pack_delta_varint& x);
+size_t
+pack_size(const pack_delta_varint& x);
+
+class unpack_delta_varint
+{
+    public:
+        unpack_delta_varint(std::vector<uint64_t>& _v) : v(_v) {}
+        ~unpack_delta_varint() throw () {}
+
+    public:
+        // Decode from [ptr, limit) into v and return the end of the
+        // encoding, or return NULL and set short_by to the bytes known to
+        // be missing, or to zero if the encoding is malformed.
+        const uint8_t* decode(const uint8_t* ptr, const uint8_t* limit, size_t* short_by) const;
+
+    public:
+        std::vector<uint64_t>& v;
+};
+
+e::unpacker
+operator >> (e::unpacker up, const unpack_delta_varint& x);
+
+// A count followed by the values in groups of four (see group_varint_encode);
+// a short final group is padded with zeros.
+class pack_group_varint
+{
+    public:
+        pack_group_varint(const uint32_t* _t, size_t _sz) : t(_t), sz(_sz) {}
+        pack_group_varint(const std::vector<uint32_t>& v)
+            : t(v.empty() ? NULL : &v[0]), sz(v.size()) {}
+        ~pack_group_varint() throw () {}
+
+    public:
+        // Write the pack_size(*this) bytes of the encoding to ptr.
+        uint8_t* encode(uint8_t* ptr) const;
+
+    public:
+        const uint32_t* t;
+        size_t sz;
+};
+
+e::packer
+operator << (e::packer pa, const pack_group_varint& x);
+size_t
+pack_size(const pack_group_varint& x);
+
+class unpack_group_varint
+{
+    public:
+        unpack_group_varint(std::vector<uint32_t>& _v) : v(_v) {}
+        ~unpack_group_varint() throw () {}
+
+    public:
+        // As unpack_delta_varint::decode
+        const uint8_t* decode(const uint8_t* ptr, const uint8_t* limit, size_t* short_by) const;
+
+    public:
+        std::vector<uint32_t>& v;
+};
+
+e::unpacker
+operator >> (e::unpacker up, const unpack_group_varint& x);
+
 /////////////////////////////////////////////////////////
 template <typename T>
 class pack_array
@@ -250,6 +460,18 @@ operator << (e::packer pa, const pack_array<T>& x)
     return pa;
 }
 
+// Arrays of fixed-width numbers are converted in bulk, straight into the
+// destination where it allows.
+e::packer operator << (e::packer pa, const pack_array<int8_t>& x);
+e::packer operator << (e::packer pa, const pack_array<int16_t>& x);
+e::packer operator << (e::packer pa, const pack_array<int32_t>& x);
+e::packer operator << (e::packer pa, const pack_array<int64_t>& x);
+e::packer operator << (e::packer pa, const pack_array<uint8_t>& x);
+e::packer operator << (e::packer pa, const pack_array<uint16_t>& x);
+e::packer operator << (e::packer pa, const pack_array<uint32_t>& x);
+e::packer operator << (e::packer pa, const pack_array<uint64_t>& x);
+e::packer operator << (e::packer pa, const pack_array<double>& x);
+
 template <typename T>
 class unpack_array
 {
@@ -274,6 +496,42 @@ operator >> (e::unpacker up, const unpack_array<T>& x)
     return up;
 }
 
+e::unpacker operator >> (e::unpacker up, const unpack_array<int8_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<int16_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<int32_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<int64_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<uint8_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<uint16_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<uint32_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<uint64_t>& x);
+e::unpacker operator >> (e::unpacker up, const unpack_array<double>& x);
+
+// Fill v with sz elements; used by the std::vector operator.  Fixed-width
+// numbers are checked against the remaining input once and converted in
+// bulk.
+template <typename T>
+e::unpacker
+unpack_elements(e::unpacker up, std::vector<T>* v, uint64_t sz)
+{
+    for (uint64_t i = 0; i < sz && !up.error(); ++i)
+    {
+        v->push_back(T());
+        up = up >> v->back();
+    }
+
+    return up;
+}
+
+e::unpacker unpack_elements(e::unpacker up, std::vector<int8_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<int16_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<int32_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<int64_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<uint8_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<uint16_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<uint32_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<uint64_t>* v, uint64_t sz);
+e::unpacker unpack_elements(e::unpacker up, std::vector<double>* v, uint64_t sz);
+
 template <typename T>
 size_t
 pack_size_array(const T* t, size_t sz)
@@ -288,6 +546,13 @@ pack_size_array(const T* t, size_t sz)
     return total;
 }
 
+template <typename T>
+size_t
+pack_size(const pack_array<T>& x)
+{
+    return pack_size_array(x.t, x.sz);
+}
+
 /////////////////////////////////////////////////////////
 
 template <typename T>
@@ -301,6 +566,13 @@ class pack_uint8
         const T& t;
 };
 
+template <typename T>
+size_t
+pack_size(const pack_uint8<T>&)
+{
+    return 1;
+}
+
 template <typename T>
 e::packer
 operator << (e::packer pa, const pack_uint8<T>& x)
@@ -341,6 +613,13 @@ class pack_uint16
         const T& t;
 };
 
+template <typename T>
+size_t
+pack_size(const pack_uint16<T>&)
+{
+    return 2;
+}
+
 template <typename T>
 e::packer
 operator << (e::packer pa, const pack_uint16<T>& x)
@@ -370,12 +649,36 @@ operator >> (e::unpacker up, const unpack_uint16<T>& x)
     return up;
 }
 
+// The destination pack_size measures with.
+class pack_size_counter : public packer::bytes_manager
+{
+    public:
+        pack_size_counter();
+        virtual ~pack_size_counter() throw ();
+
+    public:
+        size_t size() const { return m_size; }
+        virtual void write(size_t off, const uint8_t* ptr, size_t ptr_sz);
+
+    private:
+        size_t m_size;
+};
+
 } // namespace e
 
+template <typename T>
+size_t
+e :: pack_size(const T& t)
+{
+    pack_size_counter counter;
+    e::packer(counter, 0) << t;
+    return counter.size();
+}
+
 // vector<T>
 template <typename T>
 size_t
-pack_size(const typename std::vector<T>& v)
+e :: pack_size(const std::vector<T>& v)
 {
     size_t sz = e::varint_length(v.size());
 
@@ -395,9 +698,9 @@ e :: packer :: operator << (const std::vector<T>& rhs)
     const uint64_t sz = rhs.size();
     pa = pa << pack_varint(sz);
 
-    for (uint64_t i = 0; i < sz; ++i)
+    if (sz > 0)
     {
-        pa = pa << rhs[i];
+        pa = pa << pack_array<T>(&rhs[0], sz);
     }
 
     return pa;
@@ -411,20 +714,13 @@ e :: unpacker :: operator >> (std::vector<T>& rhs)
     uint64_t sz = 0;
     up = up >> unpack_varint(sz);
     rhs.clear();
-
-    for (uint64_t i = 0; i < sz; ++i)
-    {
-        rhs.push_back(T());
-        up = up >> rhs.back();
-    }
-
-    return up;
+    return unpack_elements(up, &rhs, sz);
 }
 
 // list<T>
 template <typename T>
 size_t
-pack_size(const typename std::list<T>& L)
+e :: pack_size(const std::list<T>& L)
 {
     size_t sz = e::varint_length(L.size());
 
@@ -473,7 +769,7 @@ e :: unpacker :: operator >> (std::list<T>& rhs)
 // pair<A, B>
 template <typename A, typename B>
 size_t
-pack_size(const std::pair<A, B>& p)
+e :: pack_size(const std::pair<A, B>& p)
 {
     return pack_size(p.first) + pack_size(p.second);
 }
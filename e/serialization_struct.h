@@ -0,0 +1,147 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_serialization_struct_h_
+#define e_serialization_struct_h_
+
+// C
+#include <stdint.h>
+
+// e
+#include <e/basic_packer.h>
+#include <e/basic_unpacker.h>
+#include <e/endian.h>
+#include <e/serialization.h>
+
+// Generate pack_size, pack, and unpack for a struct from lists of its fields,
+// instead of writing an E_SERIALIZATION_TRIPLET by hand:
+//
+//     struct request
+//     {
+//         uint64_t id;
+//         uint32_t flags;
+//         e::slice key;
+//         std::vector<uint64_t> ids;
+//     };
+//
+//     #define REQUEST_FIXED(X) X(uint64_t, id) X(uint32_t, flags)
+//     #define REQUEST_FIELDS(X) X(e::slice, key) X(std::vector<uint64_t>, ids)
+//     E_SERIALIZATION_STRUCT(request, REQUEST_FIXED, REQUEST_FIELDS)
+//
+// The fixed fields come first on the wire, followed by the other fields, so
+// the encoding is exactly that of "pa << x.id << x.flags << x.key << x.ids".
+// The fixed fields are bounds checked once as a group and encoded straight
+// into the destination; the others go through their own operators.  Fixed
+// fields are sized and encoded by their declared type, which must be one of
+// the fixed-width integers or double; a TYPE of a different size from the
+// field fails to compile.  Types with commas need a typedef.  Use
+// E_SERIALIZATION_NONE for an empty list.
+//
+// Invoke the macro in the struct's namespace so that argument-dependent
+// lookup finds the operators.  It works for e::packer, e::unpacker, and
+// every e::basic_packer and e::basic_unpacker, in either byte order.
+
+#define E_SERIALIZATION_NONE(X)
+
+#define E_SERIALIZATION_CHECK_FIXED(TYPE, NAME) (void) sizeof(char[sizeof(TYPE) == sizeof(x.NAME) ? 1 : -1]);
+#define E_SERIALIZATION_FIXED_SIZE(TYPE, NAME) + sizeof(x.NAME)
+#define E_SERIALIZATION_PACK_FIXED(TYPE, NAME) ptr = O::pack(x.NAME, ptr);
+#define E_SERIALIZATION_UNPACK_FIXED(TYPE, NAME) ptr = O::unpack(ptr, &x.NAME);
+#define E_SERIALIZATION_PACK_FIXED_BE(TYPE, NAME) ptr = e::big_endian::pack(x.NAME, ptr);
+#define E_SERIALIZATION_UNPACK_FIXED_BE(TYPE, NAME) ptr = e::big_endian::unpack(ptr, &x.NAME);
+#define E_SERIALIZATION_FIELD_SIZE(TYPE, NAME) + pack_size(x.NAME)
+#define E_SERIALIZATION_PACK_FIELD(TYPE, NAME) pa = pa << x.NAME;
+#define E_SERIALIZATION_UNPACK_FIELD(TYPE, NAME) up = up >> x.NAME;
+
+#define E_SERIALIZATION_STRUCT(TYPE, FIXED, FIELDS) \
+    inline size_t \
+    pack_size(const TYPE& x) \
+    { \
+        using e::pack_size; \
+        (void) x; \
+        FIXED(E_SERIALIZATION_CHECK_FIXED) \
+        return 0 FIXED(E_SERIALIZATION_FIXED_SIZE) FIELDS(E_SERIALIZATION_FIELD_SIZE); \
+    } \
+    inline e::packer \
+    operator << (e::packer pa, const TYPE& x) \
+    { \
+        const size_t fixed = 0 FIXED(E_SERIALIZATION_FIXED_SIZE); \
+        uint8_t tmp[fixed + 1]; \
+        uint8_t* const start = pa.append_in_place(fixed, &pa); \
+        uint8_t* ptr = start ? start : tmp; \
+        FIXED(E_SERIALIZATION_PACK_FIXED_BE) \
+        (void) ptr; \
+        if (!start) \
+        { \
+            pa.append(tmp, fixed, &pa); \
+        } \
+        FIELDS(E_SERIALIZATION_PACK_FIELD) \
+        return pa; \
+    } \
+    template <typename S, typename O> \
+    inline e::basic_packer<S, O> \
+    operator << (e::basic_packer<S, O> pa, const TYPE& x) \
+    { \
+        const size_t fixed = 0 FIXED(E_SERIALIZATION_FIXED_SIZE); \
+        uint8_t* ptr = pa.advance(fixed); \
+        FIXED(E_SERIALIZATION_PACK_FIXED) \
+        (void) ptr; \
+        FIELDS(E_SERIALIZATION_PACK_FIELD) \
+        return pa; \
+    } \
+    inline e::unpacker \
+    operator >> (e::unpacker up, TYPE& x) \
+    { \
+        const size_t fixed = 0 FIXED(E_SERIALIZATION_FIXED_SIZE); \
+        if (up.error() || up.remain() < fixed) \
+        { \
+            return e::unpacker::error_out(); \
+        } \
+        const uint8_t* ptr = up.start(); \
+        FIXED(E_SERIALIZATION_UNPACK_FIXED_BE) \
+        (void) ptr; \
+        up = up.advance(fixed); \
+        FIELDS(E_SERIALIZATION_UNPACK_FIELD) \
+        return up; \
+    } \
+    template <typename O> \
+    inline e::basic_unpacker<O> \
+    operator >> (e::basic_unpacker<O> up, TYPE& x) \
+    { \
+        const size_t fixed = 0 FIXED(E_SERIALIZATION_FIXED_SIZE); \
+        const uint8_t* ptr = up.advance(fixed); \
+        if (up.error()) \
+        { \
+            return up; \
+        } \
+        FIXED(E_SERIALIZATION_UNPACK_FIXED) \
+        (void) ptr; \
+        FIELDS(E_SERIALIZATION_UNPACK_FIELD) \
+        return up; \
+    }
+
+#endif // e_serialization_struct_h_
@@ -0,0 +1,153 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef e_stream_unpacker_h_
+#define e_stream_unpacker_h_
+
+// C
+#include <stdint.h>
+
+// STL
+#include <vector>
+
+// e
+#include <e/serialization.h>
+#include <e/slice.h>
+
+namespace e
+{
+
+// Decode fields as the bytes of a message arrive, instead of buffering the
+// whole message first.  Feed it chunks as they are read and unpack one field
+// at a time.  A field that is not yet complete returns NEED_MORE and consumes
+// nothing, so the same call resumes at that field after the next feed.  Only
+// the bytes of incomplete fields are kept between feeds, so the memory held
+// is bounded by the largest field rather than the whole message.
+//
+// A field that fails before the end of the buffered bytes (an overlong
+// varint, say) is an ERROR, as is one that would need more than max_field
+// bytes.  Other failures are NEED_MORE, and when the decoder knows how many
+// bytes the field is short by, unpack waits for them to arrive instead of
+// decoding the partial field again; after NEED_MORE, retry the same field.
+// After an ERROR the stream stays in error.
+//
+// Chunks are used in place when nothing is left over from earlier chunks, so
+// a chunk must stay valid until unpack returns NEED_MORE or the next call to
+// feed, whichever comes first; at NEED_MORE the unconsumed tail is copied.
+// Slices decoded from the stream may point into the chunk, and are valid only
+// until the next call to feed or until the chunk goes away.
+class stream_unpacker
+{
+    public:
+        enum status
+        {
+            SUCCESS,
+            NEED_MORE,
+            ERROR
+        };
+
+    public:
+        // max_field defaults to 1MB
+        stream_unpacker();
+        stream_unpacker(size_t max_field);
+        ~stream_unpacker() throw ();
+
+    public:
+        void feed(const uint8_t* data, size_t sz);
+        void feed(const e::slice& s) { feed(s.data(), s.size()); }
+        // On anything but SUCCESS the value of t is unspecified.
+        template <typename T> status unpack(T& t);
+        // for wrappers such as e::unpack_varint
+        template <typename T> status unpack(const T& t);
+        bool error() const { return m_error; }
+        // bytes fed but not yet consumed
+        size_t buffered() const { return m_size - m_pos; }
+        // bytes consumed since construction
+        uint64_t consumed() const { return m_consumed; }
+
+    private:
+        status finish(const e::unpacker& up);
+
+    private:
+        stream_unpacker(const stream_unpacker&);
+        stream_unpacker& operator = (const stream_unpacker&);
+
+    private:
+        const size_t m_max_field;
+        // left over from earlier chunks
+        std::vector<uint8_t> m_buf;
+        // the bytes being decoded: m_buf or the caller's chunk
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_pos;
+        // bytes past m_pos the field at m_pos needs before it can decode
+        size_t m_need;
+        uint64_t m_consumed;
+        bool m_error;
+};
+
+template <typename T>
+stream_unpacker::status
+stream_unpacker :: unpack(T& t)
+{
+    if (m_error)
+    {
+        return ERROR;
+    }
+
+    if (m_size - m_pos < m_need)
+    {
+        return NEED_MORE;
+    }
+
+    e::unpacker up(m_data + m_pos, m_size - m_pos);
+    up = up >> t;
+    return finish(up);
+}
+
+template <typename T>
+stream_unpacker::status
+stream_unpacker :: unpack(const T& t)
+{
+    if (m_error)
+    {
+        return ERROR;
+    }
+
+    if (m_size - m_pos < m_need)
+    {
+        return NEED_MORE;
+    }
+
+    e::unpacker up(m_data + m_pos, m_size - m_pos);
+    up = up >> t;
+    return finish(up);
+}
+
+} // namespace e
+
+#endif // e_stream_unpacker_h_
@@ -14,6 +14,7 @@
 #ifndef e_varint_h_
 #define e_varint_h_
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace e
@@ -21,6 +22,7 @@ namespace e
 
 #define VARINT_32_MAX_SIZE 5
 #define VARINT_64_MAX_SIZE 10
+#define GROUP_VARINT_MAX_SIZE 17
 
 // These either store a value in *v and return a pointer just past the parsed
 // value, or return NULL on error.  These routines only look at bytes in the
@@ -46,6 +48,21 @@ varint64_decode(const unsigned char* p,const unsigned char* limit, uint64_t* v)
                 reinterpret_cast<const char*>(limit), v));
 }
 
+// Decode n consecutive varints into out[0..n-1] and return a pointer just
+// past the last, or return NULL if [p..limit-1] does not hold n of them.
+// The result is exactly that of n calls to varint64_decode, but much of
+// the input is decoded a word or more at a time without branching per byte.
+const char*
+varint64_decode_n(const char* p, const char* limit, uint64_t* out, size_t n);
+
+inline const unsigned char*
+varint64_decode_n(const unsigned char* p, const unsigned char* limit, uint64_t* out, size_t n)
+{
+    return reinterpret_cast<const unsigned char*>(varint64_decode_n(
+                reinterpret_cast<const char*>(p),
+                reinterpret_cast<const char*>(limit), out, n));
+}
+
 // Write directly into a character buffer and return a pointer just past the
 // last byte written.
 // REQUIRES: dst has enough space for the value being written
@@ -54,19 +71,95 @@ varint32_encode(char* dst, uint32_t value);
 char*
 varint64_encode(char* dst, uint64_t value);
 
+// As varint64_encode, but may write up to sixteen bytes at dst; the bytes
+// after the varint are garbage.  Multi-byte values encode without branching
+// on the value.
+// REQUIRES: dst has sixteen bytes of space
+char*
+varint64_encode_slack(char* dst, uint64_t value);
+
 // Returns the length of the varint32 or varint64 encoding of "v"
 inline int
 varint_length(uint64_t v)
 {
-    int len = 1;
+    // seven bits per byte: ceil(bits / 7) for bits in [1, 64]
+    const int bits = 64 - __builtin_clzll(v | 1);
+    return (bits * 9 + 64) / 64;
+}
 
-    while (v >= 128)
-    {
-        v >>= 7;
-        len++;
-    }
+// ZigZag maps signed values to unsigned ones so that numbers of small
+// magnitude stay small: 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...
+inline uint64_t
+zigzag_encode(int64_t v)
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t
+zigzag_decode(uint64_t v)
+{
+    return static_cast<int64_t>((v >> 1) ^ (0 - (v & 1)));
+}
+
+// Write in[0..n-1] as zigzag varints and return a pointer just past the last.
+// Bytes between the returned pointer and limit may be overwritten; while
+// sixteen or more remain the values go through varint64_encode_slack.
+// REQUIRES: [dst..limit-1] has space for the n varints
+char*
+svarint64_encode_n(char* dst, char* limit, const int64_t* in, size_t n);
+
+// As varint64_decode_n, for values written by svarint64_encode_n
+const char*
+svarint64_decode_n(const char* p, const char* limit, int64_t* out, size_t n);
 
-    return len;
+inline unsigned char*
+svarint64_encode_n(unsigned char* dst, unsigned char* limit, const int64_t* in, size_t n)
+{
+    return reinterpret_cast<unsigned char*>(svarint64_encode_n(
+                reinterpret_cast<char*>(dst),
+                reinterpret_cast<char*>(limit), in, n));
+}
+
+inline const unsigned char*
+svarint64_decode_n(const unsigned char* p, const unsigned char* limit, int64_t* out, size_t n)
+{
+    return reinterpret_cast<const unsigned char*>(svarint64_decode_n(
+                reinterpret_cast<const char*>(p),
+                reinterpret_cast<const char*>(limit), out, n));
+}
+
+// Group varint packs four uint32 values behind one tag byte.  Each two-bit
+// field of the tag, starting from the low bits, holds the byte length less
+// one of the corresponding value, which follows in little-endian order.
+// Decoding looks the layout up by tag rather than testing each byte.
+
+// Returns the length of the group encoding of values[0..3]
+size_t
+group_varint_length(const uint32_t* values);
+
+// Write values[0..3] as one group and return a pointer just past it.
+// REQUIRES: dst has group_varint_length(values) bytes of space
+char*
+group_varint_encode(char* dst, const uint32_t* values);
+
+// Store one group in values[0..3] and return a pointer just past it, or
+// return NULL if [p..limit-1] does not hold a whole group.
+const char*
+group_varint_decode(const char* p, const char* limit, uint32_t* values);
+
+inline unsigned char*
+group_varint_encode(unsigned char* dst, const uint32_t* values)
+{
+    return reinterpret_cast<unsigned char*>(group_varint_encode(
+                reinterpret_cast<char*>(dst), values));
+}
+
+inline const unsigned char*
+group_varint_decode(const unsigned char* p, const unsigned char* limit, uint32_t* values)
+{
+    return reinterpret_cast<const unsigned char*>(group_varint_decode(
+                reinterpret_cast<const char*>(p),
+                reinterpret_cast<const char*>(limit), values));
 }
 
 // Helpful wrappers to match conventions from elsewhwere
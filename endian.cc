@@ -27,10 +27,184 @@
 
 // C
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define E_ENDIAN_X86
+#include <immintrin.h>
+#endif
 
 // e
 #include "e/endian.h"
 
+namespace
+{
+
+inline bool
+little_endian_host()
+{
+    const uint16_t x = 1;
+    return *reinterpret_cast<const uint8_t*>(&x) == 1;
+}
+
+void
+swap16(const uint8_t* src, uint8_t* dst, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint16_t x;
+        memcpy(&x, src + i * 2, 2);
+        x = __builtin_bswap16(x);
+        memcpy(dst + i * 2, &x, 2);
+    }
+}
+
+void
+swap32(const uint8_t* src, uint8_t* dst, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint32_t x;
+        memcpy(&x, src + i * 4, 4);
+        x = __builtin_bswap32(x);
+        memcpy(dst + i * 4, &x, 4);
+    }
+}
+
+void
+swap64(const uint8_t* src, uint8_t* dst, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t x;
+        memcpy(&x, src + i * 8, 8);
+        x = __builtin_bswap64(x);
+        memcpy(dst + i * 8, &x, 8);
+    }
+}
+
+#ifdef E_ENDIAN_X86
+// pshufb masks that reverse each 2-, 4-, or 8-byte lane, repeated for both
+// halves of an AVX2 register
+const uint8_t SHUFFLE16[32] = {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                               1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+const uint8_t SHUFFLE32[32] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                               3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+const uint8_t SHUFFLE64[32] = {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                               7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8};
+
+// Each kernel swaps as many whole registers as fit in sz bytes and returns
+// the number of bytes it swapped.
+typedef size_t (*swap_kernel)(const uint8_t* src, uint8_t* dst, size_t sz, const uint8_t* shuffle);
+
+__attribute__ ((target ("ssse3")))
+size_t
+swap_ssse3(const uint8_t* src, uint8_t* dst, size_t sz, const uint8_t* shuffle)
+{
+    const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle));
+    size_t i = 0;
+
+    for (; i + 16 <= sz; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(x, mask));
+    }
+
+    return i;
+}
+
+__attribute__ ((target ("avx2")))
+size_t
+swap_avx2(const uint8_t* src, uint8_t* dst, size_t sz, const uint8_t* shuffle)
+{
+    const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shuffle));
+    size_t i = 0;
+
+    for (; i + 64 <= sz; i += 64)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(x, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 32), _mm256_shuffle_epi8(y, mask));
+    }
+
+    for (; i + 32 <= sz; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(x, mask));
+    }
+
+    return i;
+}
+
+swap_kernel
+select_kernel()
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return swap_avx2;
+    }
+
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return swap_ssse3;
+    }
+
+    return NULL;
+}
+
+// NULL until static initialization runs, which just means the scalar loop
+const swap_kernel kernel = select_kernel();
+#endif // E_ENDIAN_X86
+
+// Copy n numbers of the given width from src to dst, reversing the bytes of
+// each if swap.
+inline void
+convert(const uint8_t* src, uint8_t* dst, size_t n, size_t width, bool swap)
+{
+    // either pointer may be NULL when there is nothing to convert
+    if (n == 0)
+    {
+        return;
+    }
+
+    if (!swap)
+    {
+        memmove(dst, src, n * width);
+        return;
+    }
+
+    size_t done = 0;
+#ifdef E_ENDIAN_X86
+    if (kernel && n * width >= 16)
+    {
+        const uint8_t* shuffle = width == 2 ? SHUFFLE16
+                               : width == 4 ? SHUFFLE32 : SHUFFLE64;
+        done = kernel(src, dst, n * width, shuffle);
+    }
+#endif
+
+    switch (width)
+    {
+        case 2:
+            swap16(src + done, dst + done, n - done / 2);
+            break;
+        case 4:
+            swap32(src + done, dst + done, n - done / 4);
+            break;
+        case 8:
+            swap64(src + done, dst + done, n - done / 8);
+            break;
+        default:
+            abort();
+    }
+}
+
+} // namespace
+
 uint8_t*
 e :: pack8be(uint8_t number, uint8_t* buffer)
 {
@@ -254,3 +428,26 @@ e :: unpackdoublele(const uint8_t* buffer, double* number)
     *number = d;
     return ret;
 }
+
+#define BULK(SZ, END, SWAP) \
+    uint8_t* \
+    e :: pack ## SZ ## END(const uint ## SZ ## _t* numbers, size_t n, uint8_t* buffer) \
+    { \
+        convert(reinterpret_cast<const uint8_t*>(numbers), buffer, n, SZ / 8, SWAP); \
+        return buffer + n * (SZ / 8); \
+    } \
+    const uint8_t* \
+    e :: unpack ## SZ ## END(const uint8_t* buffer, size_t n, uint ## SZ ## _t* numbers) \
+    { \
+        convert(buffer, reinterpret_cast<uint8_t*>(numbers), n, SZ / 8, SWAP); \
+        return buffer + n * (SZ / 8); \
+    }
+
+BULK(16, be, little_endian_host())
+BULK(16, le, !little_endian_host())
+BULK(32, be, little_endian_host())
+BULK(32, le, !little_endian_host())
+BULK(64, be, little_endian_host())
+BULK(64, le, !little_endian_host())
+
+#undef BULK
@@ -0,0 +1,123 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// e
+#include "e/crc32c.h"
+#include "e/endian.h"
+#include "e/framing.h"
+#include "e/varint.h"
+
+namespace
+{
+
+bool
+scan(const e::slice& buf, uint64_t max_frame, bool checked,
+     std::vector<e::slice>* frames, size_t* consumed)
+{
+    const uint8_t* const start = buf.data();
+    const uint8_t* const limit = start + buf.size();
+    const uint64_t trailer = checked ? sizeof(uint32_t) : 0;
+    const uint8_t* ptr = start;
+    bool ret = true;
+
+    while (ptr < limit)
+    {
+        uint64_t sz = 0;
+        const uint8_t* payload = e::varint64_decode(ptr, limit, &sz);
+
+        if (!payload)
+        {
+            // ten bytes is the longest valid varint64
+            ret = limit - ptr < 10;
+            break;
+        }
+
+        if (sz > max_frame)
+        {
+            ret = false;
+            break;
+        }
+
+        const uint64_t avail = limit - payload;
+
+        if (sz > avail || trailer > avail - sz)
+        {
+            break;
+        }
+
+        if (checked)
+        {
+            uint32_t expected;
+            e::unpack32be(payload + sz, &expected);
+
+            if (e::crc32c(payload, sz) != expected)
+            {
+                ret = false;
+                break;
+            }
+        }
+
+        frames->push_back(e::slice(payload, sz));
+        ptr = payload + sz + trailer;
+    }
+
+    *consumed = ptr - start;
+    return ret;
+}
+
+} // namespace
+
+e::packer
+e :: operator << (e::packer pa, const pack_frame& f)
+{
+    return pa << e::pack_varint(f.payload.size())
+              << e::pack_memmove(f.payload.data(), f.payload.size());
+}
+
+e::packer
+e :: operator << (e::packer pa, const pack_checked_frame& f)
+{
+    uint8_t crc[sizeof(uint32_t)];
+    e::pack32be(e::crc32c(f.payload.data(), f.payload.size()), crc);
+    return pa << e::pack_varint(f.payload.size())
+              << e::pack_memmove(f.payload.data(), f.payload.size())
+              << e::pack_memmove(crc, sizeof(crc));
+}
+
+bool
+e :: unpack_frames(const e::slice& buf, uint64_t max_frame,
+                   std::vector<e::slice>* frames, size_t* consumed)
+{
+    return scan(buf, max_frame, false, frames, consumed);
+}
+
+bool
+e :: unpack_checked_frames(const e::slice& buf, uint64_t max_frame,
+                           std::vector<e::slice>* frames, size_t* consumed)
+{
+    return scan(buf, max_frame, true, frames, consumed);
+}
@@ -30,6 +30,9 @@
 // C
 #include <stdint.h>
 
+// STL
+#include <algorithm>
+
 // e
 #include "e/buffer.h"
 #include "e/endian.h"
@@ -40,7 +43,16 @@ using e::packer;
 using e::unpacker;
 using e::pack_memmove;
 using e::unpack_memmove;
+using e::pack_size_counter;
+using e::pack_delta_varint;
+using e::pack_group_varint;
+using e::pack_svarint;
+using e::pack_svarint_array;
 using e::pack_varint;
+using e::unpack_delta_varint;
+using e::unpack_group_varint;
+using e::unpack_svarint;
+using e::unpack_svarint_array;
 using e::unpack_varint;
 
 namespace
@@ -73,6 +85,16 @@ struct string_bytes_manager : public e::packer::bytes_manager
         }
     }
 
+    virtual uint8_t* prepare(size_t off, size_t sz)
+    {
+        if (m_str->size() < off + sz)
+        {
+            m_str->resize(off + sz, '\0');
+        }
+
+        return reinterpret_cast<uint8_t*>(&(*m_str)[0]) + off;
+    }
+
     private:
         std::string* m_str;
 
@@ -103,6 +125,23 @@ struct buffer_bytes_manager : public e::packer::bytes_manager
         }
     }
 
+    virtual uint8_t* prepare(size_t off, size_t sz)
+    {
+        const size_t new_size = off + sz;
+
+        if (new_size > m_buf->capacity())
+        {
+            abort();
+        }
+
+        if (m_buf->size() < new_size)
+        {
+            m_buf->resize(new_size);
+        }
+
+        return m_buf->data() + off;
+    }
+
     private:
         e::buffer* m_buf;
 
@@ -111,6 +150,52 @@ struct buffer_bytes_manager : public e::packer::bytes_manager
         buffer_bytes_manager& operator = (const buffer_bytes_manager&);
 };
 
+// Grows the buffer geometrically instead of aborting when a write would
+// exceed its capacity.  Each growth at least doubles the capacity, so a
+// sequence of appends costs amortized constant time per byte.
+struct growable_buffer_bytes_manager : public e::packer::bytes_manager
+{
+    growable_buffer_bytes_manager(e::buffer** buf) : m_buf(buf) {}
+    virtual ~growable_buffer_bytes_manager() throw () {}
+
+    virtual void write(size_t off, const uint8_t* ptr, size_t ptr_sz)
+    {
+        memmove(prepare(off, ptr_sz), ptr, ptr_sz);
+    }
+
+    virtual uint8_t* prepare(size_t off, size_t sz)
+    {
+        const size_t new_size = off + sz;
+
+        if (new_size > (*m_buf)->capacity())
+        {
+            const size_t cap = (*m_buf)->capacity();
+            size_t new_cap = cap < 16 ? 16 : cap;
+
+            while (new_cap < new_size && new_cap <= SIZE_MAX / 2)
+            {
+                new_cap *= 2;
+            }
+
+            e::buffer::reserve(m_buf, std::max(new_cap, new_size));
+        }
+
+        if ((*m_buf)->size() < new_size)
+        {
+            (*m_buf)->resize(new_size);
+        }
+
+        return (*m_buf)->data() + off;
+    }
+
+    private:
+        e::buffer** m_buf;
+
+    private:
+        growable_buffer_bytes_manager(const growable_buffer_bytes_manager&);
+        growable_buffer_bytes_manager& operator = (const growable_buffer_bytes_manager&);
+};
+
 } // namespace
 
 packer :: bytes_manager :: bytes_manager()
@@ -121,26 +206,63 @@ packer :: bytes_manager :: ~bytes_manager() throw ()
 {
 }
 
+void
+packer :: bytes_manager :: reference(size_t off, const uint8_t* ptr, size_t ptr_sz)
+{
+    write(off, ptr, ptr_sz);
+}
+
+uint8_t*
+packer :: bytes_manager :: prepare(size_t, size_t)
+{
+    return NULL;
+}
+
 packer :: packer(std::string* str)
-    : m_mgr(new string_bytes_manager(str))
+    : m_owner(new string_bytes_manager(str))
+    , m_mgr(m_owner.get())
     , m_off(0)
 {
 }
 
 packer :: packer(std::string* str, size_t off)
-    : m_mgr(new string_bytes_manager(str))
+    : m_owner(new string_bytes_manager(str))
+    , m_mgr(m_owner.get())
     , m_off(off)
 {
 }
 
 packer :: packer(e::buffer* buf, size_t off)
-    : m_mgr(new buffer_bytes_manager(buf))
+    : m_owner(new buffer_bytes_manager(buf))
+    , m_mgr(m_owner.get())
+    , m_off(off)
+{
+}
+
+packer :: packer(e::buffer** buf, size_t off)
+    : m_owner(new growable_buffer_bytes_manager(buf))
+    , m_mgr(m_owner.get())
+    , m_off(off)
+{
+}
+
+packer :: packer(bytes_manager* mgr, size_t off)
+    : m_owner(mgr)
+    , m_mgr(mgr)
+    , m_off(off)
+{
+}
+
+packer :: packer(bytes_manager& mgr, size_t off)
+    : m_owner()
+    , m_mgr(&mgr)
     , m_off(off)
 {
 }
 
 packer :: packer(const packer& other)
-    : m_mgr(other.m_mgr)
+    : m_owner(other.m_owner)
+    , m_mgr(other.m_mgr)
     , m_off(other.m_off)
 {
 }
@@ -158,13 +280,40 @@ packer :: append(const uint8_t* ptr, size_t ptr_sz, packer* pa)
     }
 
     m_mgr->write(m_off, ptr, ptr_sz);
-    *pa = packer(m_mgr, m_off + ptr_sz);
+    *pa = *this;
+    pa->m_off += ptr_sz;
 }
 
-packer :: packer(e::compat::shared_ptr<bytes_manager> mgr, size_t off)
-    : m_mgr(mgr)
-    , m_off(off)
+void
+packer :: append_reference(const uint8_t* ptr, size_t ptr_sz, packer* pa)
+{
+    if (SIZE_MAX - m_off < ptr_sz)
+    {
+        abort();
+    }
+
+    m_mgr->reference(m_off, ptr, ptr_sz);
+    *pa = *this;
+    pa->m_off += ptr_sz;
+}
+
+uint8_t*
+packer :: append_in_place(size_t ptr_sz, packer* pa)
 {
+    if (SIZE_MAX - m_off < ptr_sz)
+    {
+        abort();
+    }
+
+    uint8_t* ptr = m_mgr->prepare(m_off, ptr_sz);
+
+    if (ptr)
+    {
+        *pa = *this;
+        pa->m_off += ptr_sz;
+    }
+
+    return ptr;
 }
 
 unpacker
@@ -175,45 +324,75 @@ unpacker :: error_out()
     return up;
 }
 
+unpacker
+unpacker :: truncated_out(size_t short_by)
+{
+    unpacker up;
+    up.m_short = short_by;
+    up.m_error = true;
+    return up;
+}
+
+unpacker
+unpacker :: malformed_out()
+{
+    unpacker up;
+    up.m_error = true;
+    up.m_malformed = true;
+    return up;
+}
+
 unpacker :: unpacker()
     : m_ptr(NULL)
     , m_end(0)
+    , m_short(0)
     , m_error(false)
+    , m_malformed(false)
 {
 }
 
 unpacker :: unpacker(const uint8_t* data, size_t sz)
     : m_ptr(data)
     , m_end(m_ptr + sz)
+    , m_short(0)
     , m_error(false)
+    , m_malformed(false)
 {
 }
 
 unpacker :: unpacker(const char* data, size_t sz)
     : m_ptr(reinterpret_cast<const uint8_t*>(data))
     , m_end(m_ptr + sz)
+    , m_short(0)
     , m_error(false)
+    , m_malformed(false)
 {
 }
 
 unpacker :: unpacker(const std::string& s)
     : m_ptr(reinterpret_cast<const uint8_t*>(s.data()))
     , m_end(m_ptr + s.size())
+    , m_short(0)
     , m_error(false)
+    , m_malformed(false)
 {
 }
 
 unpacker :: unpacker(const e::slice& s)
     : m_ptr(s.data())
     , m_end(m_ptr + s.size())
+    , m_short(0)
     , m_error(false)
+    , m_malformed(false)
 {
 }
 
 unpacker :: unpacker(const unpacker& other)
     : m_ptr(other.m_ptr)
     , m_end(other.m_end)
+    , m_short(other.m_short)
     , m_error(other.m_error)
+    , m_malformed(other.m_malformed)
 {
 }
 
@@ -224,13 +403,17 @@ unpacker :: ~unpacker() throw ()
 unpacker
 unpacker :: advance(size_t sz) const
 {
-    const uint8_t* ptr = m_ptr + sz;
+    if (m_error)
+    {
+        return *this;
+    }
 
-    if (ptr > m_end)
+    if (sz > remain())
     {
-        return error_out();
+        return truncated_out(sz - remain());
     }
 
+    const uint8_t* ptr = m_ptr + sz;
     return unpacker(ptr, m_end - ptr);
 }
 
@@ -240,7 +423,9 @@ unpacker :: operator = (const unpacker& rhs)
     // no self assign check needed
     m_ptr = rhs.m_ptr;
     m_end = rhs.m_end;
+    m_short = rhs.m_short;
     m_error = rhs.m_error;
+    m_malformed = rhs.m_malformed;
     return *this;
 }
 
@@ -276,9 +461,13 @@ PACKER(double, e::packdoublebe)
             UNPACKF(start, &rhs); \
             return unpacker(start + sz, limit - start - sz); \
         } \
+        else if (up.error()) \
+        { \
+            return up; \
+        } \
         else \
         { \
-            return unpacker::error_out(); \
+            return unpacker::truncated_out(sz - up.remain()); \
         } \
     }
 
@@ -453,6 +642,164 @@ e :: operator << (packer pa, const pack_memmove& x)
     return pa;
 }
 
+packer
+e :: operator << (packer pa, const pack_reference& x)
+{
+    pa.append_reference(x.data, x.size, &pa);
+    return pa;
+}
+
+pack_size_counter :: pack_size_counter()
+    : m_size(0)
+{
+}
+
+pack_size_counter :: ~pack_size_counter() throw ()
+{
+}
+
+void
+pack_size_counter :: write(size_t off, const uint8_t*, size_t ptr_sz)
+{
+    m_size = std::max(m_size, off + ptr_sz);
+}
+
+namespace
+{
+
+// Convert n numbers with pack_n directly into the destination, or through a
+// bounce buffer if the destination keeps its memory to itself.
+template <typename T>
+packer
+pack_bulk(packer pa, const T* t, size_t n, uint8_t* (*pack_n)(const T*, size_t, uint8_t*))
+{
+    if (n > SIZE_MAX / sizeof(T))
+    {
+        abort();
+    }
+
+    uint8_t* ptr = pa.append_in_place(n * sizeof(T), &pa);
+
+    if (ptr)
+    {
+        pack_n(t, n, ptr);
+        return pa;
+    }
+
+    uint8_t buf[1024];
+    const size_t chunk = sizeof(buf) / sizeof(T);
+
+    for (size_t i = 0; i < n; i += chunk)
+    {
+        const size_t c = std::min(chunk, n - i);
+        pack_n(t + i, c, buf);
+        pa.append(buf, c * sizeof(T), &pa);
+    }
+
+    return pa;
+}
+
+// The error for n elements of sizeof(T) bytes not fitting in up.
+template <typename T>
+unpacker
+bulk_error(unpacker up, uint64_t n)
+{
+    if (up.error())
+    {
+        return up;
+    }
+
+    const uint64_t most = SIZE_MAX / sizeof(T);
+    return unpacker::truncated_out(n > most ? SIZE_MAX : n * sizeof(T) - up.remain());
+}
+
+template <typename T>
+unpacker
+unpack_bulk(unpacker up, T* t, uint64_t n, const uint8_t* (*unpack_n)(const uint8_t*, size_t, T*))
+{
+    if (up.error() || n > up.remain() / sizeof(T))
+    {
+        return bulk_error<T>(up, n);
+    }
+
+    unpack_n(up.start(), n, t);
+    return up.advance(n * sizeof(T));
+}
+
+template <typename T>
+unpacker
+unpack_vector(unpacker up, std::vector<T>* v, uint64_t n, const uint8_t* (*unpack_n)(const uint8_t*, size_t, T*))
+{
+    // check before resizing so a corrupt count cannot allocate unboundedly
+    if (up.error() || n > up.remain() / sizeof(T))
+    {
+        return bulk_error<T>(up, n);
+    }
+
+    v->resize(n);
+    return n ? unpack_bulk(up, &(*v)[0], n, unpack_n) : up;
+}
+
+uint8_t*
+pack8_n(const uint8_t* numbers, size_t n, uint8_t* buffer)
+{
+    memmove(buffer, numbers, n);
+    return buffer + n;
+}
+
+uint8_t*
+pack8_n(const int8_t* numbers, size_t n, uint8_t* buffer)
+{
+    return pack8_n(reinterpret_cast<const uint8_t*>(numbers), n, buffer);
+}
+
+const uint8_t*
+unpack8_n(const uint8_t* buffer, size_t n, uint8_t* numbers)
+{
+    memmove(numbers, buffer, n);
+    return buffer + n;
+}
+
+const uint8_t*
+unpack8_n(const uint8_t* buffer, size_t n, int8_t* numbers)
+{
+    return unpack8_n(buffer, n, reinterpret_cast<uint8_t*>(numbers));
+}
+
+} // namespace
+
+#define BULK_PACKER(TYPE, PACKF, UNPACKF) \
+    packer \
+    e :: operator << (packer pa, const pack_array<TYPE>& x) \
+    { \
+        uint8_t* (*f)(const TYPE*, size_t, uint8_t*) = PACKF; \
+        return pack_bulk(pa, x.t, x.sz, f); \
+    } \
+    unpacker \
+    e :: operator >> (unpacker up, const unpack_array<TYPE>& x) \
+    { \
+        const uint8_t* (*f)(const uint8_t*, size_t, TYPE*) = UNPACKF; \
+        return unpack_bulk(up, x.t, x.sz, f); \
+    } \
+    unpacker \
+    e :: unpack_elements(unpacker up, std::vector<TYPE>* v, uint64_t sz) \
+    { \
+        const uint8_t* (*f)(const uint8_t*, size_t, TYPE*) = UNPACKF; \
+        return unpack_vector(up, v, sz, f); \
+    }
+
+BULK_PACKER(int8_t, pack8_n, unpack8_n)
+BULK_PACKER(int16_t, e::pack16be, e::unpack16be)
+BULK_PACKER(int32_t, e::pack32be, e::unpack32be)
+BULK_PACKER(int64_t, e::pack64be, e::unpack64be)
+BULK_PACKER(uint8_t, pack8_n, unpack8_n)
+BULK_PACKER(uint16_t, e::pack16be, e::unpack16be)
+BULK_PACKER(uint32_t, e::pack32be, e::unpack32be)
+BULK_PACKER(uint64_t, e::pack64be, e::unpack64be)
+BULK_PACKER(double, e::pack64be, e::unpack64be)
+
+#undef BULK_PACKER
+
 unpack_memmove :: unpack_memmove(void* d, size_t s)
     : m_data(static_cast<uint8_t*>(d))
     , m_size(s)
@@ -472,31 +819,425 @@ unpack_memmove :: ~unpack_memmove() throw ()
 e::unpacker
 e :: operator >> (e::unpacker up, const unpack_memmove& x)
 {
+    if (up.error())
+    {
+        return up;
+    }
+
     if (up.remain() < x.size())
     {
-        return unpacker::error_out();
+        return unpacker::truncated_out(x.size() - up.remain());
     }
 
     memmove(x.data(), up.start(), x.size());
     return up.advance(x.size());
 }
 
+namespace
+{
+
+// Why n varints starting at p did not decode: the bytes known to be
+// missing, or zero if one of them overflows.  A varint cut short by limit
+// is missing at least one byte, as is each varint after it.
+size_t
+varint_shortfall(const uint8_t* p, const uint8_t* limit, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        uint64_t v;
+        const uint8_t* next = e::varint64_decode(p, limit, &v);
+
+        if (next)
+        {
+            p = next;
+            continue;
+        }
+
+        const uint8_t* q = p;
+
+        while (q < limit && (*q & 0x80))
+        {
+            ++q;
+        }
+
+        if (q == limit && limit - p < VARINT_64_MAX_SIZE)
+        {
+            return n - i > SIZE_MAX ? SIZE_MAX : n - i;
+        }
+
+        return 0;
+    }
+
+    return 0;
+}
+
+unpacker
+varint_error(const uint8_t* p, const uint8_t* limit, uint64_t n)
+{
+    const size_t short_by = varint_shortfall(p, limit, n);
+    return short_by > 0 ? unpacker::truncated_out(short_by)
+                        : unpacker::malformed_out();
+}
+
+} // namespace
+
 e::packer
 e :: operator << (e::packer pa, const pack_varint& x)
 {
-    char buf[VARINT_64_MAX_SIZE];
-    char* ptr = varint64_encode(buf, x.x);
+    char buf[16];
+    char* ptr = varint64_encode_slack(buf, x.x);
     return pa << pack_memmove(buf, ptr - buf);
 }
 
 e::unpacker
 e :: operator >> (e::unpacker up, const unpack_varint& x)
 {
+    if (up.error())
+    {
+        return up;
+    }
+
     const uint8_t* ptr = varint64_decode(up.start(), up.limit(), &x.x);
 
     if (ptr == NULL)
     {
-        return unpacker::error_out();
+        return varint_error(up.start(), up.limit(), 1);
+    }
+
+    return up.advance(ptr - up.start());
+}
+
+e::packer
+e :: operator << (e::packer pa, const pack_svarint& x)
+{
+    return pa << pack_varint(zigzag_encode(x.x));
+}
+
+e::unpacker
+e :: operator >> (e::unpacker up, const unpack_svarint& x)
+{
+    uint64_t v = 0;
+    up = up >> unpack_varint(v);
+    x.x = zigzag_decode(v);
+    return up;
+}
+
+size_t
+e :: pack_size(const pack_svarint_array& x)
+{
+    size_t sz = 0;
+
+    for (size_t i = 0; i < x.sz; ++i)
+    {
+        sz += varint_length(zigzag_encode(x.t[i]));
+    }
+
+    return sz;
+}
+
+e::packer
+e :: operator << (e::packer pa, const pack_svarint_array& x)
+{
+    const size_t sz = pack_size(x);
+    uint8_t* ptr = pa.append_in_place(sz, &pa);
+
+    if (ptr)
+    {
+        svarint64_encode_n(ptr, ptr + sz, x.t, x.sz);
+        return pa;
+    }
+
+    // sixteen bytes of headroom keep every value on the slack path
+    std::vector<uint8_t> tmp(sz + 16);
+    svarint64_encode_n(&tmp[0], &tmp[0] + tmp.size(), x.t, x.sz);
+    return pa << pack_memmove(&tmp[0], sz);
+}
+
+e::unpacker
+e :: operator >> (e::unpacker up, const unpack_svarint_array& x)
+{
+    if (up.error() || x.sz == 0)
+    {
+        return up;
+    }
+
+    const uint8_t* ptr = svarint64_decode_n(up.start(), up.limit(), x.t, x.sz);
+
+    if (!ptr)
+    {
+        return varint_error(up.start(), up.limit(), x.sz);
+    }
+
+    return up.advance(ptr - up.start());
+}
+
+uint8_t*
+pack_delta_varint :: encode(uint8_t* ptr) const
+{
+    ptr = packvarint64(sz, ptr);
+    uint64_t prev = 0;
+
+    for (size_t i = 0; i < sz; ++i)
+    {
+        ptr = packvarint64(t[i] - prev, ptr);
+        prev = t[i];
+    }
+
+    return ptr;
+}
+
+size_t
+e :: pack_size(const pack_delta_varint& x)
+{
+    size_t sz = varint_length(x.sz);
+    uint64_t prev = 0;
+
+    for (size_t i = 0; i < x.sz; ++i)
+    {
+        sz += varint_length(x.t[i] - prev);
+        prev = x.t[i];
+    }
+
+    return sz;
+}
+
+e::packer
+e :: operator << (e::packer pa, const pack_delta_varint& x)
+{
+    const size_t sz = pack_size(x);
+    uint8_t* ptr = pa.append_in_place(sz, &pa);
+
+    if (ptr)
+    {
+        x.encode(ptr);
+        return pa;
+    }
+
+    std::vector<uint8_t> tmp(sz);
+    x.encode(&tmp[0]);
+    return pa << pack_memmove(&tmp[0], sz);
+}
+
+const uint8_t*
+unpack_delta_varint :: decode(const uint8_t* ptr, const uint8_t* limit, size_t* short_by) const
+{
+    uint64_t n = 0;
+    const uint8_t* body = varint64_decode(ptr, limit, &n);
+
+    if (!body)
+    {
+        *short_by = varint_shortfall(ptr, limit, 1);
+        return NULL;
+    }
+
+    // every gap takes at least one byte
+    const uint64_t remain = limit - body;
+
+    if (n > remain)
+    {
+        *short_by = n - remain > SIZE_MAX ? SIZE_MAX : n - remain;
+        return NULL;
+    }
+
+    v.resize(n);
+    ptr = n > 0 ? varint64_decode_n(body, limit, &v[0], n) : body;
+
+    if (!ptr)
+    {
+        *short_by = varint_shortfall(body, limit, n);
+        return NULL;
+    }
+
+    // prefix sum of the gaps
+    for (uint64_t i = 1; i < n; ++i)
+    {
+        v[i] += v[i - 1];
+    }
+
+    return ptr;
+}
+
+e::unpacker
+e :: operator >> (e::unpacker up, const unpack_delta_varint& x)
+{
+    if (up.error())
+    {
+        return up;
+    }
+
+    size_t short_by = 0;
+    const uint8_t* ptr = x.decode(up.start(), up.limit(), &short_by);
+
+    if (!ptr)
+    {
+        return short_by > 0 ? unpacker::truncated_out(short_by)
+                            : unpacker::malformed_out();
+    }
+
+    return up.advance(ptr - up.start());
+}
+
+namespace
+{
+
+// The values of group i of x, padded with zeros past the end.
+void
+group_of(const pack_group_varint& x, size_t i, uint32_t* group)
+{
+    for (size_t j = 0; j < 4; ++j)
+    {
+        group[j] = i * 4 + j < x.sz ? x.t[i * 4 + j] : 0;
+    }
+}
+
+// The bytes missing from the group at p, which every group has at least
+// five of.
+size_t
+group_shortfall(const uint8_t* p, const uint8_t* limit)
+{
+    if (p >= limit)
+    {
+        return 5;
+    }
+
+    const unsigned tag = *p;
+    const size_t sz = 5 + (tag & 3) + ((tag >> 2) & 3) + ((tag >> 4) & 3) + (tag >> 6);
+    return sz - (limit - p);
+}
+
+} // namespace
+
+uint8_t*
+pack_group_varint :: encode(uint8_t* ptr) const
+{
+    ptr = packvarint64(sz, ptr);
+    const size_t full = sz / 4;
+
+    for (size_t i = 0; i < full; ++i)
+    {
+        ptr = group_varint_encode(ptr, t + i * 4);
+    }
+
+    if (sz % 4)
+    {
+        uint32_t group[4];
+        group_of(*this, full, group);
+        ptr = group_varint_encode(ptr, group);
+    }
+
+    return ptr;
+}
+
+size_t
+e :: pack_size(const pack_group_varint& x)
+{
+    size_t sz = varint_length(x.sz);
+    const size_t full = x.sz / 4;
+
+    for (size_t i = 0; i < full; ++i)
+    {
+        sz += group_varint_length(x.t + i * 4);
+    }
+
+    if (x.sz % 4)
+    {
+        uint32_t group[4];
+        group_of(x, full, group);
+        sz += group_varint_length(group);
+    }
+
+    return sz;
+}
+
+e::packer
+e :: operator << (e::packer pa, const pack_group_varint& x)
+{
+    const size_t sz = pack_size(x);
+    uint8_t* ptr = pa.append_in_place(sz, &pa);
+
+    if (ptr)
+    {
+        x.encode(ptr);
+        return pa;
+    }
+
+    std::vector<uint8_t> tmp(sz);
+    x.encode(&tmp[0]);
+    return pa << pack_memmove(&tmp[0], sz);
+}
+
+const uint8_t*
+unpack_group_varint :: decode(const uint8_t* ptr, const uint8_t* limit, size_t* short_by) const
+{
+    uint64_t n = 0;
+    const uint8_t* body = varint64_decode(ptr, limit, &n);
+
+    if (!body)
+    {
+        *short_by = varint_shortfall(ptr, limit, 1);
+        return NULL;
+    }
+
+    // every group takes at least five bytes
+    const uint64_t groups = n / 4 + (n % 4 ? 1 : 0);
+    const uint64_t remain = limit - body;
+
+    if (groups > remain / 5)
+    {
+        *short_by = groups > SIZE_MAX / 5 ? SIZE_MAX : groups * 5 - remain;
+        return NULL;
+    }
+
+    v.resize(n);
+    const size_t full = n / 4;
+    ptr = body;
+
+    for (size_t i = 0; i < groups; ++i)
+    {
+        const uint8_t* next;
+
+        if (i < full)
+        {
+            next = group_varint_decode(ptr, limit, &v[i * 4]);
+        }
+        else
+        {
+            uint32_t group[4];
+            next = group_varint_decode(ptr, limit, group);
+
+            if (next)
+            {
+                std::copy(group, group + n % 4, v.begin() + full * 4);
+            }
+        }
+
+        if (!next)
+        {
+            *short_by = group_shortfall(ptr, limit) + 5 * (groups - i - 1);
+            return NULL;
+        }
+
+        ptr = next;
+    }
+
+    return ptr;
+}
+
+e::unpacker
+e :: operator >> (e::unpacker up, const unpack_group_varint& x)
+{
+    if (up.error())
+    {
+        return up;
+    }
+
+    size_t short_by = 0;
+    const uint8_t* ptr = x.decode(up.start(), up.limit(), &short_by);
+
+    if (!ptr)
+    {
+        return short_by > 0 ? unpacker::truncated_out(short_by)
+                            : unpacker::malformed_out();
     }
 
     return up.advance(ptr - up.start());
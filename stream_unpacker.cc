@@ -0,0 +1,142 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define __STDC_LIMIT_MACROS
+
+// C
+#include <stdint.h>
+#include <string.h>
+
+// STL
+#include <algorithm>
+
+// e
+#include "e/stream_unpacker.h"
+
+using e::stream_unpacker;
+
+namespace
+{
+
+const size_t DEFAULT_MAX_FIELD = 1024 * 1024;
+
+} // namespace
+
+stream_unpacker :: stream_unpacker()
+    : m_max_field(DEFAULT_MAX_FIELD)
+    , m_buf()
+    , m_data(NULL)
+    , m_size(0)
+    , m_pos(0)
+    , m_need(0)
+    , m_consumed(0)
+    , m_error(false)
+{
+}
+
+stream_unpacker :: stream_unpacker(size_t max_field)
+    : m_max_field(max_field)
+    , m_buf()
+    , m_data(NULL)
+    , m_size(0)
+    , m_pos(0)
+    , m_need(0)
+    , m_consumed(0)
+    , m_error(false)
+{
+}
+
+stream_unpacker :: ~stream_unpacker() throw ()
+{
+}
+
+void
+stream_unpacker :: feed(const uint8_t* data, size_t sz)
+{
+    const size_t left = m_size - m_pos;
+
+    if (left == 0)
+    {
+        // decode straight from the caller's chunk
+        m_buf.clear();
+        m_data = data;
+        m_size = sz;
+        m_pos = 0;
+        return;
+    }
+
+    if (!m_buf.empty() && m_data == &m_buf[0])
+    {
+        m_buf.erase(m_buf.begin(), m_buf.begin() + m_pos);
+    }
+    else
+    {
+        // the previous chunk was fed but not decoded to NEED_MORE
+        m_buf.assign(m_data + m_pos, m_data + m_size);
+    }
+
+    m_buf.insert(m_buf.end(), data, data + sz);
+    m_data = &m_buf[0];
+    m_size = m_buf.size();
+    m_pos = 0;
+}
+
+stream_unpacker::status
+stream_unpacker :: finish(const e::unpacker& up)
+{
+    if (up.error())
+    {
+        const size_t left = m_size - m_pos;
+        const size_t short_by = std::max(up.shortfall(), size_t(1));
+        const size_t need = short_by > SIZE_MAX - left ? SIZE_MAX : left + short_by;
+
+        if (up.malformed() || need > m_max_field)
+        {
+            m_error = true;
+            return ERROR;
+        }
+
+        m_need = need;
+
+        if (left > 0 && (m_buf.empty() || m_data != &m_buf[0]))
+        {
+            // the caller's chunk may go away once we return
+            m_buf.assign(m_data + m_pos, m_data + m_size);
+            m_data = &m_buf[0];
+            m_size = m_buf.size();
+            m_pos = 0;
+        }
+
+        return NEED_MORE;
+    }
+
+    const size_t used = m_size - m_pos - up.remain();
+    m_pos += used;
+    m_need = 0;
+    m_consumed += used;
+    return SUCCESS;
+}
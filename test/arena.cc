@@ -0,0 +1,468 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+#include <string.h>
+
+// STL
+#include <string>
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/alloc_stats.h"
+#include "e/arena.h"
+#include "e/arena_bytes.h"
+#include "e/block_source.h"
+#include "e/serialization.h"
+#include "e/slice.h"
+
+namespace
+{
+
+std::vector<int> destroyed;
+
+class counting_source : public e::block_source
+{
+    public:
+        counting_source() : outstanding(0), blocks(0) {}
+        virtual ~counting_source() throw () {}
+
+    public:
+        virtual unsigned char* allocate(size_t* sz, size_t align)
+        {
+            unsigned char* ptr = e::block_source::malloc_source()->allocate(sz, align);
+            outstanding += *sz;
+            ++blocks;
+            return ptr;
+        }
+        virtual void release(unsigned char* ptr, size_t sz)
+        {
+            outstanding -= sz;
+            --blocks;
+            e::block_source::malloc_source()->release(ptr, sz);
+        }
+
+    public:
+        size_t outstanding;
+        size_t blocks;
+};
+
+class tracked
+{
+    public:
+        tracked(int id) : m_id(id) {}
+        ~tracked() throw () { destroyed.push_back(m_id); }
+        int id() const { return m_id; }
+
+    private:
+        int m_id;
+};
+
+struct pod
+{
+    uint64_t a;
+    uint32_t b;
+};
+
+TEST(ArenaTest, BumpWithinBlock)
+{
+    e::arena a(256, 4096);
+    unsigned char* x = NULL;
+    unsigned char* y = NULL;
+    a.allocate(10, &x);
+    a.allocate(20, &y);
+    ASSERT_TRUE(x != NULL);
+    ASSERT_EQ(x + 10, y);
+    memset(x, 'x', 10);
+    memset(y, 'y', 20);
+}
+
+TEST(ArenaTest, GeometricBlocks)
+{
+    e::arena a(64, 1024);
+    unsigned char* prev = NULL;
+    size_t jumps = 0;
+
+    // many small allocations should need only a handful of blocks
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        unsigned char* ptr = NULL;
+        a.allocate(8, &ptr);
+        ASSERT_TRUE(ptr != NULL);
+        memset(ptr, 0, 8);
+
+        if (prev && ptr != prev + 8)
+        {
+            ++jumps;
+        }
+
+        prev = ptr;
+    }
+
+    // 64 + 128 + ... + 1024 then 1024s
+    ASSERT_GE(12U, jumps);
+}
+
+TEST(ArenaTest, LargeObjects)
+{
+    e::arena a(256, 1024);
+    unsigned char* x = NULL;
+    unsigned char* big = NULL;
+    unsigned char* y = NULL;
+    a.allocate(8, &x);
+    a.allocate(4096, &big);
+    a.allocate(8, &y);
+    ASSERT_TRUE(big != NULL);
+    memset(big, 0, 4096);
+    // the large allocation does not disturb the current block
+    ASSERT_EQ(x + 8, y);
+}
+
+TEST(ArenaTest, Aligned)
+{
+    e::arena a;
+    unsigned char* x = NULL;
+    a.allocate(1, &x);
+
+    for (size_t align = 1; align <= 4096; align *= 2)
+    {
+        unsigned char* ptr = NULL;
+        a.allocate_aligned(3, align, &ptr);
+        ASSERT_TRUE(ptr != NULL);
+        ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(ptr) & (align - 1));
+    }
+}
+
+TEST(ArenaTest, Reserve)
+{
+    e::arena a(64, 1024);
+    unsigned char* x = NULL;
+    a.allocate(60, &x);
+    a.reserve(100);
+    unsigned char* y = NULL;
+    unsigned char* z = NULL;
+    a.allocate(50, &y);
+    a.allocate(50, &z);
+    ASSERT_EQ(y + 50, z);
+}
+
+TEST(ArenaTest, ClearAndReuse)
+{
+    e::arena a(64, 1024);
+
+    for (size_t round = 0; round < 3; ++round)
+    {
+        unsigned char* x = NULL;
+        a.allocate(100, &x);
+        a.takeover(static_cast<unsigned char*>(malloc(10)));
+        ASSERT_TRUE(x != NULL);
+        a.clear();
+    }
+}
+
+TEST(ArenaTest, ResetRetainsBlocks)
+{
+    e::arena a(64, 1024);
+    unsigned char* first[100];
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        a.allocate(24, &first[i]);
+    }
+
+    a.reset();
+
+    // the same sequence of allocations lands on the same memory
+    for (size_t i = 0; i < 100; ++i)
+    {
+        unsigned char* ptr = NULL;
+        a.allocate(24, &ptr);
+        ASSERT_EQ(first[i], ptr);
+    }
+}
+
+TEST(ArenaTest, MarkAndRewind)
+{
+    e::arena a(64, 1024);
+    unsigned char* x = NULL;
+    a.allocate(16, &x);
+    e::arena::savepoint sp = a.mark();
+    unsigned char* y = NULL;
+    a.allocate(16, &y);
+
+    for (size_t i = 0; i < 50; ++i)
+    {
+        unsigned char* tmp = NULL;
+        a.allocate(32, &tmp);
+        a.takeover(static_cast<unsigned char*>(malloc(8)));
+    }
+
+    a.rewind(sp);
+    unsigned char* z = NULL;
+    a.allocate(16, &z);
+    ASSERT_EQ(y, z);
+}
+
+TEST(ArenaTest, RewindToEmpty)
+{
+    e::arena a(64, 1024);
+    e::arena::savepoint sp = a.mark();
+    unsigned char* x = NULL;
+    a.allocate(16, &x);
+    a.rewind(sp);
+    unsigned char* y = NULL;
+    a.allocate(16, &y);
+    ASSERT_EQ(x, y);
+}
+
+TEST(ArenaTest, CreateRunsDestructorsInReverse)
+{
+    destroyed.clear();
+
+    {
+        e::arena a;
+        tracked* t1 = a.create<tracked>(1);
+        tracked* t2 = a.create<tracked>(2);
+        ASSERT_EQ(1, t1->id());
+        ASSERT_EQ(2, t2->id());
+        e::arena::savepoint sp = a.mark();
+        a.create<tracked>(3);
+        a.create<tracked>(4);
+        a.rewind(sp);
+        ASSERT_EQ(2U, destroyed.size());
+        ASSERT_EQ(4, destroyed[0]);
+        ASSERT_EQ(3, destroyed[1]);
+        a.reset();
+        ASSERT_EQ(4U, destroyed.size());
+        ASSERT_EQ(2, destroyed[2]);
+        ASSERT_EQ(1, destroyed[3]);
+        a.create<tracked>(5);
+    }
+
+    ASSERT_EQ(5U, destroyed.size());
+    ASSERT_EQ(5, destroyed[4]);
+}
+
+TEST(ArenaTest, CreateAlignsAndConstructs)
+{
+    e::arena a;
+    unsigned char* x = NULL;
+    a.allocate(1, &x);
+    pod* p = a.create<pod>();
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(p) % __alignof__(pod));
+    ASSERT_EQ(0U, p->a);
+    std::string* s = a.create<std::string>(5, 'x');
+    ASSERT_EQ("xxxxx", *s);
+    std::vector<e::slice>* v = a.create<std::vector<e::slice> >();
+    v->push_back(e::slice(*s));
+    ASSERT_EQ(1U, v->size());
+}
+
+TEST(ArenaTest, BlockSource)
+{
+    counting_source src;
+
+    {
+        e::arena a(1024, 16384, &src);
+        unsigned char* x = NULL;
+        a.allocate(100, &x);
+        ASSERT_EQ(1U, src.blocks);
+        e::arena::savepoint sp = a.mark();
+        a.allocate_aligned(8192, 64, &x);
+        ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(x) % 64);
+        ASSERT_EQ(2U, src.blocks);
+        a.rewind(sp);
+        ASSERT_EQ(1U, src.blocks);
+        a.allocate(2000, &x);
+        ASSERT_EQ(2U, src.blocks);
+    }
+
+    ASSERT_EQ(0U, src.outstanding);
+    ASSERT_EQ(0U, src.blocks);
+}
+
+TEST(ArenaTest, MmapBlockSource)
+{
+    for (int huge = 0; huge < 2; ++huge)
+    {
+        e::mmap_block_source src(huge);
+        e::arena a(4096, 4 * 1024 * 1024, &src);
+        unsigned char* x = NULL;
+        a.allocate(10, &x);
+        ASSERT_TRUE(x != NULL);
+        memset(x, 'x', 10);
+        a.allocate_aligned(2 * 1024 * 1024, 1 << 16, &x);
+        ASSERT_TRUE(x != NULL);
+        ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(x) % (1 << 16));
+        memset(x, 'y', 2 * 1024 * 1024);
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            a.allocate(1000, &x);
+            ASSERT_TRUE(x != NULL);
+            memset(x, 'z', 1000);
+        }
+
+        a.clear();
+
+        if (!huge)
+        {
+            ASSERT_EQ(0U, src.huge_page_blocks());
+        }
+    }
+}
+
+TEST(ArenaTest, Extend)
+{
+    e::arena a(1024, 16384);
+    unsigned char* x = NULL;
+    unsigned char* y = NULL;
+    a.allocate(100, &x);
+    ASSERT_TRUE(a.extend(x, 100, 500));
+    a.allocate(10, &y);
+    ASSERT_TRUE(y == x + 500);
+    ASSERT_FALSE(a.extend(x, 500, 600));
+    ASSERT_TRUE(a.extend(y, 10, 20));
+    ASSERT_FALSE(a.extend(y, 20, 4096));
+}
+
+TEST(ArenaTest, ArenaBytesMatchesString)
+{
+    e::arena a;
+    e::arena_bytes ab(&a);
+    std::string str;
+    ab.pack() << uint32_t(0xdeadbeef) << e::slice("hello world") << uint64_t(42);
+    e::packer(&str) << uint32_t(0xdeadbeef) << e::slice("hello world") << uint64_t(42);
+    ASSERT_TRUE(ab.as_slice() == e::slice(str));
+    ab.pack() << uint8_t(7);
+    e::packer(&str, str.size()) << uint8_t(7);
+    ASSERT_TRUE(ab.as_slice() == e::slice(str));
+    ab.pack_at(0) << uint32_t(0x01020304);
+    e::packer(&str, 0) << uint32_t(0x01020304);
+    ASSERT_TRUE(ab.as_slice() == e::slice(str));
+}
+
+TEST(ArenaTest, ArenaBytesGrowsInPlace)
+{
+    e::arena a(4096, 4096);
+    e::arena_bytes ab(&a);
+    ab.pack() << uint64_t(1);
+    const uint8_t* first = ab.data();
+    e::packer pa = ab.pack();
+
+    for (uint64_t i = 2; i <= 128; ++i)
+    {
+        pa = pa << i;
+    }
+
+    ASSERT_EQ(1024U, ab.size());
+    ASSERT_TRUE(ab.data() == first);
+
+    // something else allocated on top forces a copy
+    unsigned char* x = NULL;
+    a.allocate(1, &x);
+    ab.reserve(2048);
+    ASSERT_TRUE(ab.data() != first);
+    ASSERT_EQ(1024U, ab.size());
+    e::unpacker up(ab.as_slice());
+
+    for (uint64_t i = 1; i <= 128; ++i)
+    {
+        uint64_t v = 0;
+        up = up >> v;
+        ASSERT_EQ(i, v);
+    }
+
+    ASSERT_FALSE(up.error());
+}
+
+TEST(ArenaTest, ArenaBytesOutlivedByArena)
+{
+    e::arena a;
+    e::slice key1;
+    e::slice key2;
+
+    {
+        e::arena_bytes ab(&a);
+        ab.pack() << e::slice("first");
+        key1 = ab.as_slice();
+        ab.clear();
+        ab.pack() << e::slice("second");
+        key2 = ab.as_slice();
+    }
+
+    std::string s1;
+    std::string s2;
+    e::packer(&s1) << e::slice("first");
+    e::packer(&s2) << e::slice("second");
+    ASSERT_TRUE(key1 == e::slice(s1));
+    ASSERT_TRUE(key2 == e::slice(s2));
+}
+
+TEST(ArenaTest, Stats)
+{
+    e::arena a(1024, 16384);
+    unsigned char* x = NULL;
+    a.allocate(100, &x);
+    a.allocate(2000, &x);
+    a.allocate(5000, &x);
+    e::arena_stats s;
+    a.stats(&s);
+
+    if (!e::alloc_stats_enabled())
+    {
+        ASSERT_EQ(0U, s.bytes_requested);
+        ASSERT_EQ(0U, s.bytes_reserved);
+        ASSERT_EQ(0U, s.blocks);
+        return;
+    }
+
+    ASSERT_EQ(7100U, s.bytes_requested);
+    ASSERT_EQ(2U, s.blocks);
+    ASSERT_EQ(1U, s.large_objects);
+    ASSERT_GE(s.bytes_reserved, 1024U + 2000U + 5000U);
+    ASSERT_GE(s.bytes_wasted, 924U);
+    ASSERT_EQ(s.bytes_reserved, s.high_water);
+
+    e::arena_stats before;
+    e::global_arena_stats(&before);
+    a.clear();
+    a.stats(&s);
+    ASSERT_EQ(0U, s.bytes_requested);
+    ASSERT_EQ(0U, s.bytes_reserved);
+    ASSERT_EQ(0U, s.blocks);
+    ASSERT_EQ(0U, s.large_objects);
+    ASSERT_GE(s.high_water, 1024U + 2000U + 5000U);
+    e::arena_stats after;
+    e::global_arena_stats(&after);
+    ASSERT_EQ(before.bytes_requested + 7100U, after.bytes_requested);
+    ASSERT_EQ(before.blocks - 2, after.blocks);
+}
+
+} // namespace
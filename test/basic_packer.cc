@@ -0,0 +1,303 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+
+// STL
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/arena.h"
+#include "e/arena_bytes.h"
+#include "e/basic_packer.h"
+#include "e/basic_unpacker.h"
+#include "e/buffer.h"
+
+namespace
+{
+
+// only has e::packer operators
+struct legacy
+{
+    legacy() : a(0), b() {}
+    uint32_t a;
+    std::string b;
+};
+
+e::packer
+operator << (e::packer pa, const legacy& x)
+{
+    return pa << x.a << e::slice(x.b);
+}
+
+// one template operator serves every packer
+struct modern
+{
+    modern() : a(0), b(0) {}
+    uint16_t a;
+    uint64_t b;
+};
+
+template <typename P>
+P
+operator << (P pa, const modern& x)
+{
+    return pa << x.a << e::pack_varint(x.b);
+}
+
+// writes its body, then goes back to fill in the length before it
+struct backfill
+{
+    backfill() : b() {}
+    std::string b;
+};
+
+e::packer
+operator << (e::packer pa, const backfill& x)
+{
+    e::packer end = pa << uint32_t(0) << e::pack_memmove(x.b.data(), x.b.size());
+    pa << uint32_t(x.b.size());
+    return end;
+}
+
+template <typename P>
+P
+pack_everything(P pa)
+{
+    std::vector<uint32_t> v;
+    v.push_back(1);
+    v.push_back(0xdeadbeef);
+    std::list<e::slice> l;
+    l.push_back(e::slice("list"));
+    l.push_back(e::slice(""));
+    legacy lg;
+    lg.a = 42;
+    lg.b = "legacy";
+    modern md;
+    md.a = 7;
+    md.b = 300;
+    uint16_t arr[3] = {1, 2, 3};
+    return pa << int8_t(-1) << int16_t(-2) << int32_t(-3) << int64_t(-4)
+              << uint8_t(1) << uint16_t(2) << uint32_t(3) << uint64_t(4)
+              << double(3.5) << e::slice("hello world")
+              << e::pack_varint(1ULL << 40)
+              << e::pack_memmove("raw", 3)
+              << e::pack_reference("ref", 3)
+              << e::pack_array<uint16_t>(arr, 3)
+              << e::pack_uint8<int>(200)
+              << v << l << std::make_pair(uint8_t(9), e::slice("pair"))
+              << lg << md;
+}
+
+std::string
+expected()
+{
+    std::string s;
+    pack_everything(e::packer(&s));
+    return s;
+}
+
+TEST(BasicPackerTest, StringSink)
+{
+    std::string s;
+    e::string_packer pa = pack_everything(e::string_packer(&s, 0));
+    ASSERT_EQ(expected(), s);
+    ASSERT_EQ(s.size(), pa.offset());
+    // overwrite in place
+    e::string_packer(&s, 0) << int8_t(5);
+    ASSERT_EQ(5, s[0]);
+    ASSERT_EQ(expected().size(), s.size());
+}
+
+TEST(BasicPackerTest, EarlierWrite)
+{
+    backfill bf;
+    bf.b = "body";
+    std::string s;
+    e::string_packer pa = e::string_packer(&s, 0) << bf << uint8_t(9);
+    ASSERT_EQ(std::string("\x00\x00\x00\x04" "body" "\x09", 9), s);
+    ASSERT_EQ(9U, pa.offset());
+}
+
+TEST(BasicPackerTest, BufferSinks)
+{
+    std::auto_ptr<e::buffer> buf(e::buffer::create(1024));
+    pack_everything(e::buffer_packer(buf.get(), 0));
+    ASSERT_EQ(expected(), buf->as_slice().str());
+
+    e::buffer* grow = e::buffer::create(0);
+    pack_everything(e::growable_buffer_packer(&grow, 0));
+    ASSERT_EQ(expected(), grow->as_slice().str());
+    delete grow;
+}
+
+TEST(BasicPackerTest, ArenaSink)
+{
+    e::arena a;
+    e::arena_bytes ab(&a);
+    pack_everything(e::arena_packer(&ab, 0));
+    ASSERT_EQ(expected(), ab.as_slice().str());
+}
+
+TEST(BasicPackerTest, Advance)
+{
+    std::string s;
+    e::string_packer pa(&s, 2);
+    uint8_t* ptr = pa.advance(4);
+    e::pack32be(0x01020304, ptr);
+    ASSERT_EQ(6U, pa.offset());
+    ASSERT_EQ(std::string("\x00\x00\x01\x02\x03\x04", 6), s);
+}
+
+template <typename P>
+P
+pack_numbers(P pa)
+{
+    std::vector<uint32_t> v;
+    v.push_back(1);
+    v.push_back(0xdeadbeef);
+    std::list<e::slice> l;
+    l.push_back(e::slice("list"));
+    modern md;
+    md.a = 7;
+    md.b = 300;
+    int64_t arr[3] = {-1, 2, -3};
+    uint64_t ids[3] = {100, 200, 201};
+    uint32_t lens[5] = {0, 300, 70000, 0xffffffffU, 9};
+    int64_t deltas[3] = {-5, 1000, INT64_MIN};
+    return pa << e::pack_delta_varint(ids, 3) << e::pack_group_varint(lens, 5)
+              << e::pack_svarint(-300) << e::pack_svarint_array(deltas, 3)
+              << int8_t(-1) << int16_t(-2) << int32_t(-3) << int64_t(-4)
+              << uint8_t(1) << uint16_t(2) << uint32_t(3) << uint64_t(4)
+              << double(3.5) << e::slice("hello world")
+              << e::pack_array<int64_t>(arr, 3)
+              << v << l << std::make_pair(uint8_t(9), e::slice("pair"))
+              << md;
+}
+
+template <typename U>
+U
+unpack_numbers(U up)
+{
+    int8_t i8 = 0;
+    int16_t i16 = 0;
+    int32_t i32 = 0;
+    int64_t i64 = 0;
+    uint8_t u8 = 0;
+    uint16_t u16 = 0;
+    uint32_t u32 = 0;
+    uint64_t u64 = 0;
+    double d = 0;
+    e::slice s;
+    int64_t arr[3];
+    std::vector<uint32_t> v;
+    std::list<e::slice> l;
+    std::pair<uint8_t, e::slice> p;
+    uint16_t mda = 0;
+    uint64_t mdb = 0;
+    std::vector<uint64_t> ids;
+    std::vector<uint32_t> lens;
+    int64_t sv = 0;
+    int64_t deltas[3];
+    up = up >> e::unpack_delta_varint(ids) >> e::unpack_group_varint(lens)
+            >> e::unpack_svarint(sv) >> e::unpack_svarint_array(deltas, 3)
+            >> i8 >> i16 >> i32 >> i64 >> u8 >> u16 >> u32 >> u64 >> d >> s
+            >> e::unpack_array<int64_t>(arr, 3) >> v >> l >> p
+            >> mda >> e::unpack_varint(mdb);
+
+    if (up.error())
+    {
+        return up;
+    }
+
+    ASSERT_EQ(3U, ids.size());
+    ASSERT_EQ(201U, ids[2]);
+    ASSERT_EQ(5U, lens.size());
+    ASSERT_EQ(0xffffffffU, lens[3]);
+    ASSERT_EQ(9U, lens[4]);
+    ASSERT_EQ(-300, sv);
+    ASSERT_EQ(-5, deltas[0]);
+    ASSERT_EQ(INT64_MIN, deltas[2]);
+    ASSERT_EQ(-1, i8);
+    ASSERT_EQ(-2, i16);
+    ASSERT_EQ(-3, i32);
+    ASSERT_EQ(-4, i64);
+    ASSERT_EQ(1U, u8);
+    ASSERT_EQ(2U, u16);
+    ASSERT_EQ(3U, u32);
+    ASSERT_EQ(4U, u64);
+    ASSERT_EQ(3.5, d);
+    ASSERT_EQ("hello world", s.str());
+    ASSERT_EQ(-3, arr[2]);
+    ASSERT_EQ(2U, v.size());
+    ASSERT_EQ(0xdeadbeefU, v[1]);
+    ASSERT_EQ(1U, l.size());
+    ASSERT_EQ("list", l.front().str());
+    ASSERT_EQ(9U, p.first);
+    ASSERT_EQ("pair", p.second.str());
+    ASSERT_EQ(7U, mda);
+    ASSERT_EQ(300U, mdb);
+    return up;
+}
+
+TEST(BasicPackerTest, LittleEndian)
+{
+    std::string s;
+    e::string_packer_le(&s, 0) << uint32_t(0x01020304) << e::pack_varint(300)
+                               << double(1.0);
+    ASSERT_EQ(std::string("\x04\x03\x02\x01\xac\x02\x00\x00\x00\x00\x00\x00\xf0\x3f", 14), s);
+
+    s.clear();
+    e::string_packer_le pa = pack_numbers(e::string_packer_le(&s, 0));
+    ASSERT_EQ(s.size(), pa.offset());
+    e::unpacker_le up = unpack_numbers(e::unpacker_le(e::slice(s)));
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0U, up.remain());
+
+    // the same fields as e::packer writes them, which is the default order
+    std::string be;
+    pack_numbers(e::packer(&be));
+    ASSERT_EQ(s.size(), be.size());
+    ASSERT_NE(s, be);
+    e::basic_unpacker<e::big_endian> beup = unpack_numbers(e::basic_unpacker<e::big_endian>(e::slice(be)));
+    ASSERT_FALSE(beup.error());
+    ASSERT_EQ(0U, beup.remain());
+
+    // every truncation fails
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        up = unpack_numbers(e::unpacker_le(e::slice(s.data(), i)));
+        ASSERT_TRUE(up.error());
+    }
+}
+
+} // namespace
@@ -29,17 +29,38 @@
 #include <stdint.h>
 
 // C++
+#include <list>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 // e
 #include "th.h"
 #include "e/buffer.h"
+#include "e/buffer_chain.h"
+#include "e/buffer_ref.h"
 
 #define ASSERT_MEMCMP(X, Y, S) ASSERT_EQ(0, memcmp(X, Y, S))
 
 namespace
 {
 
+// no pack_size of its own
+struct message
+{
+    message() : id(0), names(), tags() {}
+    uint64_t id;
+    std::vector<e::slice> names;
+    std::list<std::pair<uint16_t, e::slice> > tags;
+};
+
+e::packer
+operator << (e::packer pa, const message& m)
+{
+    return pa << m.id << m.names << m.tags;
+}
+
 TEST(BufferTest, CtorAndDtor)
 {
     // Create a buffer without any size
@@ -189,4 +210,368 @@ TEST(BufferTest, VectorUnpackFail)
     ASSERT_EQ(0xbabe, vector_good[3]);
 }
 
+TEST(BufferTest, GrowablePack)
+{
+    e::buffer* buf = e::buffer::create(0);
+    e::packer pa = e::buffer::pack_growable(&buf);
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        pa = pa << i;
+    }
+
+    ASSERT_EQ(4000U, buf->size());
+    ASSERT_LE(4000U, buf->capacity());
+    ASSERT_GT(8000U, buf->capacity());
+    e::unpacker up = buf->unpack();
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        uint32_t x;
+        up = up >> x;
+        ASSERT_EQ(i, x);
+    }
+
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0U, up.remain());
+    delete buf;
+}
+
+TEST(BufferTest, ReserveAndShrink)
+{
+    e::buffer* buf = e::buffer::create("xyz", 3);
+    e::buffer::reserve(&buf, 2);
+    ASSERT_EQ(3U, buf->capacity());
+    e::buffer::reserve(&buf, 64);
+    ASSERT_EQ(3U, buf->size());
+    ASSERT_EQ(64U, buf->capacity());
+    ASSERT_TRUE(buf->cmp("xyz", 3));
+    e::buffer::pack_growable_at(&buf, 3) << uint8_t('!');
+    ASSERT_TRUE(buf->cmp("xyz!", 4));
+    e::buffer::shrink_to_fit(&buf);
+    ASSERT_EQ(4U, buf->capacity());
+    ASSERT_TRUE(buf->cmp("xyz!", 4));
+    delete buf;
+}
+
+TEST(BufferTest, CopyPreservesCapacity)
+{
+    std::auto_ptr<e::buffer> buf(e::buffer::create(16));
+    buf->pack() << uint32_t(0xdeadbeef);
+    std::auto_ptr<e::buffer> cpy(buf->copy());
+    ASSERT_EQ(16U, cpy->capacity());
+    ASSERT_EQ(4U, cpy->size());
+    ASSERT_TRUE(cpy->cmp("\xde\xad\xbe\xef", 4));
+}
+
+TEST(BufferTest, RefSharesAllocation)
+{
+    e::buffer_ref a(e::buffer::create("hello world", 11));
+    ASSERT_TRUE(a.unique());
+    e::buffer_ref b(a);
+    e::buffer_ref c = a.sub(6, 5);
+    ASSERT_FALSE(a.unique());
+    ASSERT_EQ(a.data(), b.data());
+    ASSERT_EQ(a.data() + 6, c.data());
+    ASSERT_EQ(5U, c.size());
+    ASSERT_TRUE(c.as_slice() == e::slice("world"));
+}
+
+TEST(BufferTest, RefCopyOnWrite)
+{
+    e::buffer_ref a(e::buffer::create("hello world", 11));
+    e::buffer_ref c = a.sub(6, 5);
+    const uint8_t* orig = c.data();
+    uint8_t* mut = c.mutable_data();
+    ASSERT_NE(orig, mut);
+    mut[0] = 'W';
+    ASSERT_TRUE(c.as_slice() == e::slice("World"));
+    ASSERT_TRUE(a.as_slice() == e::slice("hello world"));
+    // both are now sole owners, so writes happen in place
+    ASSERT_TRUE(a.unique());
+    ASSERT_TRUE(c.unique());
+    ASSERT_EQ(a.data(), a.mutable_data());
+    ASSERT_EQ(mut, c.mutable_data());
+}
+
+TEST(BufferTest, PackSize)
+{
+    std::vector<uint32_t> v(300, 7);
+    ASSERT_EQ(2U + 1200U, e::pack_size(v));
+    std::list<uint8_t> l(5, 1);
+    ASSERT_EQ(6U, e::pack_size(l));
+    ASSERT_EQ(2U + 6U, e::pack_size(std::make_pair(uint16_t(1), e::slice("hello"))));
+    std::vector<std::vector<uint16_t> > vv(3, std::vector<uint16_t>(2));
+    ASSERT_EQ(1U + 3U * 5U, e::pack_size(vv));
+    ASSERT_EQ(3U, e::pack_size(e::pack_varint(20000)));
+    ASSERT_EQ(10U, e::pack_size(e::pack_memmove("0123456789", 10)));
+    uint64_t arr[4] = {1, 2, 3, 4};
+    ASSERT_EQ(32U, e::pack_size(e::pack_array<uint64_t>(arr, 4)));
+    ASSERT_EQ(1U, e::pack_size(e::pack_uint8<int>(5)));
+}
+
+TEST(BufferTest, PackSizeExact)
+{
+    const std::string bs(200, 'b');
+    message m;
+    m.id = 42;
+    m.names.push_back(e::slice("alpha"));
+    m.names.push_back(e::slice(bs));
+    m.tags.push_back(std::make_pair(uint16_t(1), e::slice("one")));
+    m.tags.push_back(std::make_pair(uint16_t(2), e::slice("")));
+    std::vector<message> ms(3, m);
+    const size_t sz = e::pack_size(ms);
+    std::auto_ptr<e::buffer> buf(e::buffer::create(sz));
+    buf->pack() << ms;
+    ASSERT_EQ(sz, buf->size());
+    std::string str;
+    e::packer(&str) << ms;
+    ASSERT_EQ(str.size(), sz);
+}
+
+template <typename T>
+std::string
+pack_one_by_one(const std::vector<T>& v)
+{
+    std::string s;
+    e::packer pa(&s);
+    pa = pa << e::pack_varint(v.size());
+
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        pa = pa << v[i];
+    }
+
+    return s;
+}
+
+TEST(BufferTest, BulkArrays)
+{
+    std::vector<uint64_t> u64;
+    std::vector<int32_t> s32;
+    std::vector<uint16_t> u16;
+    std::vector<int8_t> s8;
+    std::vector<double> d;
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        u64.push_back(i * 0x0102030405060708ULL);
+        s32.push_back(-int32_t(i) * 77);
+        u16.push_back(i * 31);
+        s8.push_back(-int8_t(i));
+        d.push_back(i / 3.0);
+    }
+
+    // directly into a string
+    std::string s;
+    e::packer(&s) << u64 << s32 << u16 << s8 << d;
+    ASSERT_EQ(pack_one_by_one(u64) + pack_one_by_one(s32) + pack_one_by_one(u16)
+              + pack_one_by_one(s8) + pack_one_by_one(d), s);
+
+    // through the bounce buffer
+    e::buffer_chain chain;
+    chain.pack() << u64 << s32 << u16 << s8 << d;
+    ASSERT_EQ(s, chain.str());
+
+    // into a fixed buffer
+    std::auto_ptr<e::buffer> buf(e::buffer::create(s.size()));
+    buf->pack() << u64 << s32 << u16 << s8 << d;
+    ASSERT_EQ(s, buf->as_slice().str());
+
+    std::vector<uint64_t> u64b;
+    std::vector<int32_t> s32b;
+    std::vector<uint16_t> u16b;
+    std::vector<int8_t> s8b;
+    std::vector<double> db;
+    e::unpacker up = buf->unpack() >> u64b >> s32b >> u16b >> s8b >> db;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0U, up.remain());
+    ASSERT_TRUE(u64 == u64b);
+    ASSERT_TRUE(s32 == s32b);
+    ASSERT_TRUE(u16 == u16b);
+    ASSERT_TRUE(s8 == s8b);
+    ASSERT_TRUE(d == db);
+
+    uint32_t arr[5] = {1, 2, 3, 4, 5};
+    uint32_t back[5] = {0, 0, 0, 0, 0};
+    std::string a;
+    e::packer(&a) << e::pack_array<uint32_t>(arr, 5);
+    ASSERT_EQ(20U, a.size());
+    up = e::unpacker(a) >> e::unpack_array<uint32_t>(back, 5);
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0, memcmp(arr, back, sizeof(arr)));
+    up = e::unpacker(a.data(), 19) >> e::unpack_array<uint32_t>(back, 5);
+    ASSERT_TRUE(up.error());
+}
+
+TEST(BufferTest, BulkVectorRejectsBadCount)
+{
+    // claims 2^62 elements but holds one
+    std::string s;
+    e::packer(&s) << e::pack_varint(1ULL << 62) << uint64_t(1);
+    std::vector<uint64_t> v;
+    e::unpacker up = e::unpacker(s) >> v;
+    ASSERT_TRUE(up.error());
+    ASSERT_EQ(0U, v.size());
+}
+
+// Pack p and check the encoding against pack_size and against packing into a
+// buffer_chain, which has no in-place writes.  Then check that u fails on
+// every truncation and decodes all of the encoding, which it returns.
+template <typename P, typename U>
+std::string
+check_codec(const P& p, const U& u)
+{
+    std::string s;
+    e::packer(&s) << p;
+    ASSERT_EQ(s.size(), e::pack_size(p));
+    e::buffer_chain chain;
+    chain.pack() << p;
+    ASSERT_EQ(s, chain.str());
+
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        e::unpacker up = e::unpacker(s.data(), i) >> u;
+        ASSERT_TRUE(up.error());
+        // never mistaken for corrupt input
+        ASSERT_FALSE(up.malformed());
+        ASSERT_GT(up.shortfall(), 0U);
+    }
+
+    e::unpacker up = e::unpacker(s) >> u;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0U, up.remain());
+    return s;
+}
+
+// A count larger than the input is rejected before allocating.
+template <typename U>
+void
+check_rejects_huge_count(const U& u)
+{
+    std::string s;
+    e::packer(&s) << e::pack_varint(1ULL << 62) << e::pack_varint(1);
+    ASSERT_TRUE((e::unpacker(s) >> u).error());
+}
+
+TEST(BufferTest, DeltaVarint)
+{
+    std::vector<uint64_t> ids;
+    uint64_t id = 1ULL << 40;
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        id += 1 + (i * 7919) % 200;
+        ids.push_back(id);
+    }
+
+    std::vector<uint64_t> back;
+    std::string s = check_codec(e::pack_delta_varint(ids), e::unpack_delta_varint(back));
+    ASSERT_TRUE(ids == back);
+    // 1000 IDs and the count in six bytes for the first, two for the count,
+    // and no more than two for each gap
+    ASSERT_LE(s.size(), 2U + 6U + 2 * 999U);
+
+    // unsorted and empty sequences round trip too
+    std::vector<uint64_t> mixed;
+    mixed.push_back(5);
+    mixed.push_back(0);
+    mixed.push_back(UINT64_MAX);
+    mixed.push_back(1);
+    check_codec(e::pack_delta_varint(mixed), e::unpack_delta_varint(back));
+    ASSERT_TRUE(mixed == back);
+    std::vector<uint64_t> empty;
+    back.assign(3, 1);
+    check_codec(e::pack_delta_varint(empty), e::unpack_delta_varint(back));
+    ASSERT_EQ(0U, back.size());
+
+    check_rejects_huge_count(e::unpack_delta_varint(back));
+
+    // a gap that never ends is malformed, however much input follows it
+    std::string bad;
+    e::packer(&bad) << e::pack_varint(2);
+    bad.append(11, '\x80');
+    bad.append(1, '\x01');
+    ASSERT_TRUE((e::unpacker(bad) >> e::unpack_delta_varint(back)).malformed());
+    // while a list cut short says how much is missing
+    e::unpacker up = e::unpacker(bad.data(), 3) >> e::unpack_delta_varint(back);
+    ASSERT_FALSE(up.malformed());
+    ASSERT_EQ(2U, up.shortfall());
+}
+
+TEST(BufferTest, Svarint)
+{
+    // timestamps that wander both ways, as deltas
+    std::vector<int64_t> deltas;
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        deltas.push_back(static_cast<int64_t>((i * 7919) % 2001) - 1000);
+    }
+
+    std::vector<int64_t> back(deltas.size());
+    std::string s = check_codec(e::pack_svarint_array(&deltas[0], deltas.size()),
+                                e::unpack_svarint_array(&back[0], back.size()));
+    ASSERT_TRUE(deltas == back);
+    // no delta takes more than two bytes
+    ASSERT_LE(s.size(), 2 * 1000U);
+
+    // small magnitudes of either sign stay small; INT64_MIN takes the most
+    int64_t x = 0;
+    s = check_codec(e::pack_svarint(-1), e::unpack_svarint(x));
+    ASSERT_EQ(1U, s.size());
+    ASSERT_EQ(-1, x);
+    s = check_codec(e::pack_svarint(INT64_MIN), e::unpack_svarint(x));
+    ASSERT_EQ(10U, s.size());
+    ASSERT_EQ(INT64_MIN, x);
+    // an overlong value is malformed, while a short array is missing a byte
+    // for each value it lacks
+    std::string bad(11, '\x80');
+    bad.append(16, '\x01');
+    ASSERT_TRUE((e::unpacker(bad) >> e::unpack_svarint_array(&back[0], 3)).malformed());
+    e::unpacker up = e::unpacker(bad.data(), 2) >> e::unpack_svarint_array(&back[0], 3);
+    ASSERT_FALSE(up.malformed());
+    ASSERT_EQ(3U, up.shortfall());
+}
+
+TEST(BufferTest, GroupVarint)
+{
+    std::vector<uint32_t> lens;
+
+    for (size_t i = 0; i < 1001; ++i)
+    {
+        lens.push_back((i * 2654435761U) >> (i % 32));
+    }
+
+    std::vector<uint32_t> back;
+    check_codec(e::pack_group_varint(lens), e::unpack_group_varint(back));
+    ASSERT_TRUE(lens == back);
+
+    // every partial group and the empty sequence round trip in the count
+    // plus five to seventeen bytes per group
+    for (size_t n = 0; n < 9; ++n)
+    {
+        std::vector<uint32_t> prefix(lens.begin(), lens.begin() + n);
+        back.assign(3, 1);
+        std::string s = check_codec(e::pack_group_varint(prefix), e::unpack_group_varint(back));
+        ASSERT_TRUE(prefix == back);
+        ASSERT_LE(s.size(), 1U + (n + 3) / 4 * 17);
+        ASSERT_GE(s.size(), 1U + (n + 3) / 4 * 5);
+    }
+
+    check_rejects_huge_count(e::unpack_group_varint(back));
+
+    // an overlong count is malformed
+    std::string bad(11, '\x80');
+    bad.append(16, '\x01');
+    ASSERT_TRUE((e::unpacker(bad) >> e::unpack_group_varint(back)).malformed());
+    // while a group cut short says how much of it is missing
+    std::string one;
+    e::packer(&one) << e::pack_group_varint(std::vector<uint32_t>(1, UINT32_MAX));
+    ASSERT_EQ(9U, one.size());
+    e::unpacker up = e::unpacker(one.data(), 7) >> e::unpack_group_varint(back);
+    ASSERT_FALSE(up.malformed());
+    ASSERT_EQ(2U, up.shortfall());
+}
+
 } // namespace
@@ -0,0 +1,187 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+
+// STL
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/buffer_chain.h"
+
+namespace
+{
+
+TEST(BufferChainTest, PackByReference)
+{
+    std::string payload(1000, 'x');
+    e::buffer_chain chain;
+    chain.pack() << uint32_t(0xdeadbeef)
+                 << e::pack_varint(payload.size())
+                 << e::pack_reference(payload.data(), payload.size())
+                 << uint16_t(0xface);
+    ASSERT_EQ(4U + 2U + 1000U + 2U, chain.size());
+    // header, borrowed payload, trailer
+    ASSERT_EQ(3U, chain.chunk_count());
+    ASSERT_EQ(reinterpret_cast<const uint8_t*>(payload.data()), chain.chunk(1).data());
+
+    std::vector<iovec> iov;
+    chain.to_iovec(&iov);
+    ASSERT_EQ(3U, iov.size());
+    ASSERT_EQ(6U, iov[0].iov_len);
+    ASSERT_EQ(1000U, iov[1].iov_len);
+    ASSERT_EQ(2U, iov[2].iov_len);
+    ASSERT_EQ(std::string("\xde\xad\xbe\xef\xe8\x07", 6) + payload + "\xfa\xce", chain.str());
+}
+
+TEST(BufferChainTest, SmallReferencesAreCopied)
+{
+    e::buffer_chain chain;
+    chain.pack() << uint8_t('<') << e::pack_reference(e::slice("small")) << uint8_t('>');
+    ASSERT_EQ(1U, chain.chunk_count());
+    ASSERT_EQ("<small>", chain.str());
+}
+
+TEST(BufferChainTest, OwnedBuffers)
+{
+    e::buffer_chain chain;
+    e::buffer* buf = e::buffer::create(8);
+    buf->pack() << uint16_t(0x0102);
+    chain.append(buf);
+    // fills the spare capacity of buf before allocating
+    chain.pack() << uint32_t(0x03040506);
+    ASSERT_EQ(1U, chain.chunk_count());
+    chain.pack() << uint32_t(0x0708090a);
+    ASSERT_EQ(2U, chain.chunk_count());
+    ASSERT_EQ(std::string("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a", 10), chain.str());
+    chain.clear();
+    ASSERT_TRUE(chain.empty());
+    ASSERT_EQ(0U, chain.chunk_count());
+}
+
+TEST(BufferChainTest, UnpackAcrossChunks)
+{
+    std::string a("\x01\x02\x03", 3);
+    std::string b("\x04\x05\x0b" "hello", 8);
+    std::string c(" world\xfe\xff", 8);
+    e::buffer_chain chain;
+    chain.append_copy(reinterpret_cast<const uint8_t*>(a.data()), a.size());
+    chain.append(e::buffer::create(b.data(), b.size()));
+    chain.append(e::buffer::create(c.data(), c.size()));
+    ASSERT_EQ(3U, chain.chunk_count());
+
+    uint32_t x = 0;
+    e::slice s;
+    uint16_t y = 0;
+    uint8_t z = 0;
+    e::chain_unpacker up = chain.unpack() >> x;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0x01020304U, x);
+    up = up >> z >> s;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0x05U, z);
+    ASSERT_TRUE(s == e::slice("hello world"));
+    up = up >> y;
+    ASSERT_EQ(0xfeffU, y);
+    ASSERT_EQ(0U, up.remain());
+    ASSERT_FALSE(up.error());
+    up = up >> z;
+    ASSERT_TRUE(up.error());
+}
+
+TEST(BufferChainTest, UnpackVarintAcrossChunks)
+{
+    e::buffer_chain chain;
+    std::string a("\xff\xff", 2);
+    std::string b("\x03", 1);
+    chain.append(e::buffer::create(a.data(), a.size()));
+    chain.append(e::buffer::create(b.data(), b.size()));
+    uint64_t v = 0;
+    e::chain_unpacker up = chain.unpack() >> e::unpack_varint(v);
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0xffffULL, v);
+    ASSERT_EQ(0U, up.remain());
+}
+
+TEST(BufferChainTest, UnpackManyStraddlingValues)
+{
+    std::string msg;
+    e::packer pa(&msg);
+    pa = pa << e::slice("hello world");
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        pa = pa << i << e::pack_varint(uint64_t(i) << 30);
+    }
+
+    pa = pa << e::slice("goodbye");
+
+    // three-byte chunks put most values across a boundary
+    e::buffer_chain chain;
+
+    for (size_t i = 0; i < msg.size(); i += 3)
+    {
+        const size_t sz = std::min(msg.size() - i, size_t(3));
+        chain.append(e::buffer::create(msg.data() + i, sz));
+    }
+
+    e::slice hello;
+    e::slice goodbye;
+    e::chain_unpacker up = chain.unpack() >> hello;
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        uint32_t x = 0;
+        uint64_t v = 0;
+        up = up >> x >> e::unpack_varint(v);
+        ASSERT_FALSE(up.error());
+        ASSERT_EQ(i, x);
+        ASSERT_EQ(uint64_t(i) << 30, v);
+    }
+
+    up = up >> goodbye;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0U, up.remain());
+    // the copies the slices point into outlive the numbers decoded since
+    ASSERT_TRUE(hello == e::slice("hello world"));
+    ASSERT_TRUE(goodbye == e::slice("goodbye"));
+
+    // a slice longer than the rest of the chain fails without copying it
+    e::buffer_chain truncated;
+    std::string head;
+    e::packer(&head) << e::slice(std::string(100, 'x'));
+    truncated.append(e::buffer::create(head.data(), 2));
+    truncated.append(e::buffer::create(head.data() + 2, 50));
+    up = truncated.unpack() >> hello;
+    ASSERT_TRUE(up.error());
+}
+
+} // namespace
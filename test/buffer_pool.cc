@@ -0,0 +1,121 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+
+// e
+#include "th.h"
+#include "e/buffer.h"
+#include "e/buffer_pool.h"
+
+namespace
+{
+
+TEST(BufferPoolTest, DisabledByDefault)
+{
+    ASSERT_FALSE(e::buffer_pool::enabled());
+    e::buffer_pool::stats before;
+    e::buffer_pool::get_stats(&before);
+    delete e::buffer::create(100);
+    e::buffer_pool::stats after;
+    e::buffer_pool::get_stats(&after);
+    ASSERT_EQ(before.hits, after.hits);
+    ASSERT_EQ(before.misses, after.misses);
+    ASSERT_EQ(0U, after.retained_bytes);
+    // without the pool, buffers come straight from the heap with no header
+    e::buffer* b = e::buffer::create(100);
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(b) % 16);
+    delete b;
+}
+
+TEST(BufferPoolTest, ReuseBySizeClass)
+{
+    e::buffer_pool::enable(1 << 20, 1 << 16);
+    e::buffer_pool::stats base;
+    e::buffer_pool::get_stats(&base);
+
+    e::buffer* a = e::buffer::create(100);
+    e::buffer_pool::stats s;
+    e::buffer_pool::get_stats(&s);
+    ASSERT_EQ(base.hits, s.hits);
+    ASSERT_EQ(base.misses + 1, s.misses);
+
+    const uintptr_t first = reinterpret_cast<uintptr_t>(a);
+    delete a;
+    e::buffer_pool::get_stats(&s);
+    ASSERT_LT(0U, s.retained_bytes);
+
+    // a slightly different size in the same class reuses the block
+    e::buffer* b = e::buffer::create(110);
+    ASSERT_EQ(first, reinterpret_cast<uintptr_t>(b));
+    ASSERT_EQ(110U, b->capacity());
+    ASSERT_EQ(0U, b->size());
+    e::buffer_pool::get_stats(&s);
+    ASSERT_EQ(base.hits + 1, s.hits);
+    ASSERT_EQ(0U, s.retained_bytes);
+    delete b;
+
+    // blocks over the limit are never pooled
+    delete e::buffer::create(1 << 17);
+    e::buffer_pool::get_stats(&s);
+    ASSERT_EQ(base.misses + 1, s.misses);
+
+    e::buffer_pool::trim();
+    e::buffer_pool::get_stats(&s);
+    ASSERT_EQ(0U, s.retained_bytes);
+    e::buffer_pool::disable();
+}
+
+TEST(BufferPoolTest, RetentionLimit)
+{
+    e::buffer_pool::enable(256, 1 << 16);
+    e::buffer* a = e::buffer::create(200);
+    e::buffer* b = e::buffer::create(200);
+    delete a;
+    delete b;
+    e::buffer_pool::stats s;
+    e::buffer_pool::get_stats(&s);
+    ASSERT_EQ(256U, s.retained_bytes);
+    e::buffer_pool::trim();
+    e::buffer_pool::disable();
+}
+
+TEST(BufferPoolTest, DisableWithCachedBlocks)
+{
+    e::buffer_pool::enable(1 << 20, 1 << 16);
+    e::buffer* a = e::buffer::create(10);
+    e::buffer_pool::disable();
+    // allocated while enabled, freed while disabled
+    delete a;
+    e::buffer_pool::enable(1 << 20, 1 << 16);
+    delete e::buffer::create(10);
+    e::buffer_pool::disable();
+    e::buffer_pool::trim();
+}
+
+} // namespace
@@ -0,0 +1,156 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+#include <string.h>
+
+// POSIX
+#include <pthread.h>
+
+// STL
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/concurrent_arena.h"
+
+namespace
+{
+
+struct worker
+{
+    worker() : arena(NULL), id(0), ptrs(), sizes() {}
+    e::concurrent_arena* arena;
+    unsigned char id;
+    std::vector<unsigned char*> ptrs;
+    std::vector<size_t> sizes;
+};
+
+void*
+work(void* _w)
+{
+    worker* w = static_cast<worker*>(_w);
+    e::concurrent_arena::region r(w->arena);
+
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        // mostly small, with the occasional large allocation
+        size_t sz = (i % 97 == 0) ? 5000 : 1 + (i * 7) % 61;
+        unsigned char* ptr = NULL;
+        r.allocate(sz, &ptr);
+
+        if (!ptr)
+        {
+            return NULL;
+        }
+
+        memset(ptr, w->id, sz);
+        w->ptrs.push_back(ptr);
+        w->sizes.push_back(sz);
+    }
+
+    return NULL;
+}
+
+TEST(ConcurrentArenaTest, SingleThread)
+{
+    e::concurrent_arena ca(4096, 256);
+    e::concurrent_arena::region r(&ca);
+    unsigned char* x = NULL;
+    unsigned char* y = NULL;
+    r.allocate(10, &x);
+    r.allocate(10, &y);
+    ASSERT_EQ(x + 10, y);
+    unsigned char* z = NULL;
+    r.allocate_aligned(8, 64, &z);
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(z) & 63);
+    unsigned char* big = NULL;
+    r.allocate(100000, &big);
+    ASSERT_TRUE(big != NULL);
+    memset(big, 0, 100000);
+    ca.clear();
+    // the region's chunk went with the clear, so this must come from a new one
+    r.allocate(10, &x);
+    ASSERT_TRUE(x != NULL);
+    memset(x, 0xff, 10);
+    r.allocate(10, &y);
+    ASSERT_EQ(x + 10, y);
+    memset(y, 0xff, 10);
+}
+
+TEST(ConcurrentArenaTest, UnalignedChunkSize)
+{
+    // chunks round up to 112 bytes, which the blocks must hold
+    e::concurrent_arena ca(100, 100);
+    e::concurrent_arena::region r(&ca);
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        unsigned char* x = NULL;
+        r.allocate(40, &x);
+        ASSERT_TRUE(x != NULL);
+        memset(x, 0xff, 40);
+    }
+}
+
+TEST(ConcurrentArenaTest, ManyThreads)
+{
+    e::concurrent_arena ca(64 * 1024, 1024);
+    const size_t N = 8;
+    worker workers[N];
+    pthread_t threads[N];
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        workers[i].arena = &ca;
+        workers[i].id = static_cast<unsigned char>(i + 1);
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, work, &workers[i]));
+    }
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        ASSERT_EQ(0, pthread_join(threads[i], NULL));
+    }
+
+    // every allocation still holds the pattern its owner wrote, so no two
+    // threads were handed overlapping memory
+    for (size_t i = 0; i < N; ++i)
+    {
+        ASSERT_EQ(20000U, workers[i].ptrs.size());
+
+        for (size_t j = 0; j < workers[i].ptrs.size(); ++j)
+        {
+            for (size_t k = 0; k < workers[i].sizes[j]; ++k)
+            {
+                ASSERT_EQ(workers[i].id, workers[i].ptrs[j][k]);
+            }
+        }
+    }
+}
+
+} // namespace
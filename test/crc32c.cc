@@ -0,0 +1,95 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <string.h>
+
+// STL
+#include <string>
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/crc32c.h"
+
+namespace
+{
+
+const uint8_t*
+u8(const char* s)
+{
+    return reinterpret_cast<const uint8_t*>(s);
+}
+
+TEST(CRC32CTest, KnownValues)
+{
+    ASSERT_EQ(0x00000000U, e::crc32c(u8(""), 0));
+    ASSERT_EQ(0xe3069283U, e::crc32c(u8("123456789"), 9));
+    ASSERT_EQ(0xe3069283U, e::crc32c_portable(0, u8("123456789"), 9));
+    // RFC 3720, B.4: 32 bytes of zeros and of ones
+    std::vector<uint8_t> buf(32, 0);
+    ASSERT_EQ(0x8a9136aaU, e::crc32c(&buf[0], buf.size()));
+    buf.assign(32, 0xff);
+    ASSERT_EQ(0x62a8ab43U, e::crc32c(&buf[0], buf.size()));
+}
+
+TEST(CRC32CTest, HardwareMatchesPortable)
+{
+    std::vector<uint8_t> buf(1024);
+
+    for (size_t i = 0; i < buf.size(); ++i)
+    {
+        buf[i] = i * 31 + (i >> 3);
+    }
+
+    // every alignment and every tail length
+    for (size_t off = 0; off < 16; ++off)
+    {
+        for (size_t sz = 0; off + sz <= buf.size(); sz += 13)
+        {
+            ASSERT_EQ(e::crc32c_portable(0, &buf[off], sz),
+                      e::crc32c(&buf[off], sz));
+        }
+    }
+}
+
+TEST(CRC32CTest, Extend)
+{
+    const char* s = "the quick brown fox jumps over the lazy dog";
+    const size_t sz = strlen(s);
+    const uint32_t whole = e::crc32c(u8(s), sz);
+
+    for (size_t split = 0; split <= sz; ++split)
+    {
+        uint32_t crc = e::crc32c(u8(s), split);
+        ASSERT_EQ(whole, e::crc32c(crc, u8(s) + split, sz - split));
+        crc = e::crc32c_portable(0, u8(s), split);
+        ASSERT_EQ(whole, e::crc32c_portable(crc, u8(s) + split, sz - split));
+    }
+}
+
+} // namespace
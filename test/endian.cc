@@ -28,8 +28,13 @@
 #pragma GCC diagnostic ignored "-Wfloat-equal"
 
 // C
+#include <stdint.h>
 #include <string.h>
 
+// STL
+#include <algorithm>
+#include <vector>
+
 // e
 #include "th.h"
 #include "e/endian.h"
@@ -161,4 +166,95 @@ TEST(EndianTest, Unpack)
     ASSERT_EQ(9006104071832581.0, d);
 }
 
+// the vector's storage, or NULL when it has none
+template <typename T>
+T*
+start(std::vector<T>& v)
+{
+    return v.empty() ? NULL : &v[0];
+}
+
+// exercise the SIMD body and the scalar tail at every length, and n == 0
+// with NULL pointers
+TEST(EndianTest, Bulk)
+{
+    for (size_t n = 0; n < 80; ++n)
+    {
+        std::vector<uint16_t> u16(n);
+        std::vector<uint32_t> u32(n);
+        std::vector<uint64_t> u64(n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            u64[i] = 0x0123456789abcdefULL * (i + 1);
+            u32[i] = u64[i] >> 16;
+            u16[i] = u64[i] >> 40;
+        }
+
+        std::vector<uint8_t> bulk(n * 8);
+        std::vector<uint8_t> single(n * 8);
+        std::vector<uint64_t> back64(n);
+        std::vector<uint32_t> back32(n);
+        std::vector<uint16_t> back16(n);
+        uint8_t* const b = start(bulk);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            e::pack16be(u16[i], &single[i * 2]);
+        }
+
+        ASSERT_TRUE(e::pack16be(start(u16), n, b) == b + n * 2);
+        ASSERT_TRUE(std::equal(bulk.begin(), bulk.begin() + n * 2, single.begin()));
+        ASSERT_TRUE(e::unpack16be(b, n, start(back16)) == b + n * 2);
+        ASSERT_TRUE(back16 == u16);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            e::pack32be(u32[i], &single[i * 4]);
+        }
+
+        ASSERT_TRUE(e::pack32be(start(u32), n, b) == b + n * 4);
+        ASSERT_TRUE(std::equal(bulk.begin(), bulk.begin() + n * 4, single.begin()));
+        ASSERT_TRUE(e::unpack32be(b, n, start(back32)) == b + n * 4);
+        ASSERT_TRUE(back32 == u32);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            e::pack64be(u64[i], &single[i * 8]);
+        }
+
+        ASSERT_TRUE(e::pack64be(start(u64), n, b) == b + n * 8);
+        ASSERT_TRUE(bulk == single);
+        ASSERT_TRUE(e::unpack64be(b, n, start(back64)) == b + n * 8);
+        ASSERT_TRUE(back64 == u64);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            e::pack64le(u64[i], &single[i * 8]);
+        }
+
+        ASSERT_TRUE(e::pack64le(start(u64), n, b) == b + n * 8);
+        ASSERT_TRUE(bulk == single);
+        ASSERT_TRUE(e::unpack64le(b, n, start(back64)) == b + n * 8);
+        ASSERT_TRUE(back64 == u64);
+    }
+}
+
+TEST(EndianTest, BulkSignedAndDouble)
+{
+    int32_t s32[3] = {-1, 0, 0x12345678};
+    double d[2] = {1.5, -2.25};
+    uint8_t buf[16];
+    uint8_t one[8];
+    e::pack32be(s32, 3, buf);
+    ASSERT_MEMCMP(buf, "\xff\xff\xff\xff\x00\x00\x00\x00\x12\x34\x56\x78", 12);
+    e::pack64be(d, 2, buf);
+    e::packdoublebe(d[1], one);
+    ASSERT_MEMCMP(buf + 8, one, 8);
+    double back[2];
+    e::unpack64be(buf, 2, back);
+    ASSERT_EQ(1.5, back[0]);
+    ASSERT_EQ(-2.25, back[1]);
+}
+
 } // namespace
@@ -0,0 +1,168 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// STL
+#include <string>
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/framing.h"
+
+namespace
+{
+
+TEST(FramingTest, RoundTrip)
+{
+    std::string buf;
+    e::packer pa(&buf);
+
+    for (size_t i = 0; i < 50; ++i)
+    {
+        pa = pa << e::pack_frame(std::string(i * 7, 'a' + i % 26));
+    }
+
+    // the frame encoding is that of a packed slice
+    std::string s;
+    e::packer(&s) << e::slice(std::string(14, 'c'));
+    ASSERT_EQ(s, buf.substr(0 + 1 + 7 + 1, s.size()));
+    ASSERT_EQ(s.size(), e::pack_size(e::pack_frame(std::string(14, 'c'))));
+
+    std::vector<e::slice> frames;
+    size_t consumed = 0;
+    ASSERT_TRUE(e::unpack_frames(buf, 1024, &frames, &consumed));
+    ASSERT_EQ(buf.size(), consumed);
+    ASSERT_EQ(50U, frames.size());
+
+    for (size_t i = 0; i < 50; ++i)
+    {
+        ASSERT_EQ(std::string(i * 7, 'a' + i % 26), frames[i].str());
+        // zero copy
+        ASSERT_TRUE(frames[i].data() >= reinterpret_cast<const uint8_t*>(buf.data()));
+        ASSERT_TRUE(frames[i].data() <= reinterpret_cast<const uint8_t*>(buf.data()) + buf.size());
+    }
+}
+
+TEST(FramingTest, Partial)
+{
+    std::string buf;
+    e::packer(&buf) << e::pack_frame(std::string("hello"))
+                    << e::pack_frame(std::string(300, 'x'));
+    const size_t first = 6;
+
+    for (size_t cut = 0; cut < buf.size(); ++cut)
+    {
+        std::vector<e::slice> frames;
+        size_t consumed = 0;
+        ASSERT_TRUE(e::unpack_frames(e::slice(buf.data(), cut), 1024, &frames, &consumed));
+
+        if (cut < first)
+        {
+            ASSERT_EQ(0U, frames.size());
+            ASSERT_EQ(0U, consumed);
+        }
+        else
+        {
+            ASSERT_EQ(1U, frames.size());
+            ASSERT_EQ(first, consumed);
+            ASSERT_EQ("hello", frames[0].str());
+        }
+    }
+}
+
+TEST(FramingTest, MaxFrame)
+{
+    std::string buf;
+    e::packer(&buf) << e::pack_frame(std::string("ok"))
+                    << e::pack_frame(std::string(100, 'x'));
+    std::vector<e::slice> frames;
+    size_t consumed = 0;
+    // rejected from the length alone, before the payload arrives
+    ASSERT_FALSE(e::unpack_frames(e::slice(buf.data(), 5), 99, &frames, &consumed));
+    ASSERT_EQ(1U, frames.size());
+    ASSERT_EQ(3U, consumed);
+    frames.clear();
+    ASSERT_TRUE(e::unpack_frames(buf, 100, &frames, &consumed));
+    ASSERT_EQ(2U, frames.size());
+}
+
+TEST(FramingTest, BadVarint)
+{
+    std::string buf(12, '\xff');
+    std::vector<e::slice> frames;
+    size_t consumed = 0;
+    ASSERT_TRUE(e::unpack_frames(e::slice(buf.data(), 9), UINT64_MAX, &frames, &consumed));
+    ASSERT_FALSE(e::unpack_frames(buf, UINT64_MAX, &frames, &consumed));
+    ASSERT_EQ(0U, frames.size());
+    ASSERT_EQ(0U, consumed);
+}
+
+TEST(FramingTest, Checked)
+{
+    std::string buf;
+    e::packer pa(&buf);
+
+    for (size_t i = 0; i < 20; ++i)
+    {
+        pa = pa << e::pack_checked_frame(std::string(i * 11, 'a' + i));
+    }
+
+    size_t expected = 0;
+
+    for (size_t i = 0; i < 20; ++i)
+    {
+        expected += e::pack_size(e::pack_checked_frame(std::string(i * 11, 'a' + i)));
+    }
+
+    ASSERT_EQ(expected, buf.size());
+    std::vector<e::slice> frames;
+    size_t consumed = 0;
+    ASSERT_TRUE(e::unpack_checked_frames(buf, 1024, &frames, &consumed));
+    ASSERT_EQ(buf.size(), consumed);
+    ASSERT_EQ(20U, frames.size());
+
+    for (size_t i = 0; i < 20; ++i)
+    {
+        ASSERT_EQ(std::string(i * 11, 'a' + i), frames[i].str());
+    }
+
+    // a frame missing part of its checksum is incomplete
+    frames.clear();
+    ASSERT_TRUE(e::unpack_checked_frames(e::slice(buf.data(), buf.size() - 1), 1024, &frames, &consumed));
+    ASSERT_EQ(19U, frames.size());
+
+    // corrupt the payload of the third frame
+    const size_t third = 5 + 1 + 11 + 4 + 1;
+    ASSERT_EQ('c', buf[third]);
+    buf[third] = 'C';
+    frames.clear();
+    ASSERT_FALSE(e::unpack_checked_frames(buf, 1024, &frames, &consumed));
+    ASSERT_EQ(2U, frames.size());
+    ASSERT_EQ(third - 1, consumed);
+}
+
+} // namespace
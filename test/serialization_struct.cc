@@ -0,0 +1,178 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+
+// STL
+#include <string>
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/buffer_chain.h"
+#include "e/serialization_struct.h"
+
+namespace
+{
+
+struct request
+{
+    request() : id(0), flags(0), weight(0), key(), ids() {}
+    uint64_t id;
+    uint32_t flags;
+    double weight;
+    e::slice key;
+    std::vector<uint64_t> ids;
+};
+
+#define REQUEST_FIXED(X) X(uint64_t, id) X(uint32_t, flags) X(double, weight)
+#define REQUEST_FIELDS(X) X(e::slice, key) X(std::vector<uint64_t>, ids)
+E_SERIALIZATION_STRUCT(request, REQUEST_FIXED, REQUEST_FIELDS)
+
+struct only_fixed
+{
+    only_fixed() : a(0), b(0) {}
+    int8_t a;
+    int16_t b;
+};
+
+#define ONLY_FIXED(X) X(int8_t, a) X(int16_t, b)
+E_SERIALIZATION_STRUCT(only_fixed, ONLY_FIXED, E_SERIALIZATION_NONE)
+
+// nests a generated struct as an ordinary field
+struct envelope
+{
+    envelope() : inner(), tail() {}
+    request inner;
+    only_fixed tail;
+};
+
+#define ENVELOPE_FIELDS(X) X(request, inner) X(only_fixed, tail)
+E_SERIALIZATION_STRUCT(envelope, E_SERIALIZATION_NONE, ENVELOPE_FIELDS)
+
+request
+make_request()
+{
+    request r;
+    r.id = 0xdeadbeefcafebabeULL;
+    r.flags = 7;
+    r.weight = 0.5;
+    r.key = e::slice("the key");
+    r.ids.push_back(1);
+    r.ids.push_back(2);
+    return r;
+}
+
+TEST(SerializationStructTest, MatchesHandWritten)
+{
+    request r = make_request();
+    std::string generated;
+    std::string by_hand;
+    e::packer(&generated) << r;
+    e::packer(&by_hand) << r.id << r.flags << r.weight << r.key << r.ids;
+    ASSERT_EQ(by_hand, generated);
+    ASSERT_EQ(generated.size(), pack_size(r));
+
+    std::string fast;
+    e::string_packer(&fast, 0) << r;
+    ASSERT_EQ(generated, fast);
+
+    // a destination without in-place writes
+    e::buffer_chain chain;
+    chain.pack() << r;
+    ASSERT_EQ(generated, chain.str());
+}
+
+TEST(SerializationStructTest, RoundTrip)
+{
+    envelope e1;
+    e1.inner = make_request();
+    e1.tail.a = -3;
+    e1.tail.b = -300;
+    std::string s;
+    e::packer(&s) << e1;
+    ASSERT_EQ(s.size(), pack_size(e1));
+    ASSERT_EQ(pack_size(e1.inner) + 3U, pack_size(e1));
+
+    envelope e2;
+    e::unpacker up = e::unpacker(s) >> e2;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0U, up.remain());
+    ASSERT_EQ(e1.inner.id, e2.inner.id);
+    ASSERT_EQ(e1.inner.flags, e2.inner.flags);
+    ASSERT_EQ(e1.inner.weight, e2.inner.weight);
+    ASSERT_TRUE(e1.inner.key == e2.inner.key);
+    ASSERT_TRUE(e1.inner.ids == e2.inner.ids);
+    ASSERT_EQ(e1.tail.a, e2.tail.a);
+    ASSERT_EQ(e1.tail.b, e2.tail.b);
+}
+
+TEST(SerializationStructTest, Truncated)
+{
+    request r = make_request();
+    std::string s;
+    e::packer(&s) << r;
+
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        request out;
+        e::unpacker up = e::unpacker(s.data(), i) >> out;
+        ASSERT_TRUE(up.error());
+    }
+}
+
+TEST(SerializationStructTest, LittleEndian)
+{
+    envelope e1;
+    e1.inner = make_request();
+    e1.tail.a = -3;
+    e1.tail.b = -300;
+    std::string s;
+    e::string_packer_le(&s, 0) << e1;
+    ASSERT_EQ(s.size(), pack_size(e1));
+    // id is the first field on the wire
+    ASSERT_EQ('\xbe', s[0]);
+
+    envelope e2;
+    e::unpacker_le up = e::unpacker_le(e::slice(s)) >> e2;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(0U, up.remain());
+    ASSERT_EQ(e1.inner.id, e2.inner.id);
+    ASSERT_EQ(e1.inner.weight, e2.inner.weight);
+    ASSERT_TRUE(e1.inner.key == e2.inner.key);
+    ASSERT_TRUE(e1.inner.ids == e2.inner.ids);
+    ASSERT_EQ(e1.tail.b, e2.tail.b);
+
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        up = e::unpacker_le(e::slice(s.data(), i)) >> e2;
+        ASSERT_TRUE(up.error());
+    }
+}
+
+} // namespace
@@ -0,0 +1,271 @@
+// Copyright (c) 2016, Robert Escriva
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of this project nor the names of its contributors may
+//       be used to endorse or promote products derived from this software
+//       without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+#include <stdlib.h>
+
+// STL
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// e
+#include "th.h"
+#include "e/stream_unpacker.h"
+
+namespace
+{
+
+struct decoder
+{
+    decoder() : field(0), a(0), b(), bs(), c(), d(0), peak(0) {}
+
+    // decode whatever is available, resuming at the field it stopped on
+    e::stream_unpacker::status run(e::stream_unpacker* su)
+    {
+        e::stream_unpacker::status st = e::stream_unpacker::SUCCESS;
+
+        while (field < 4 && st == e::stream_unpacker::SUCCESS)
+        {
+            peak = std::max(peak, su->buffered());
+
+            switch (field)
+            {
+                case 0: st = su->unpack(a); break;
+                case 1: st = su->unpack(b); if (st == e::stream_unpacker::SUCCESS) { bs = b.str(); } break;
+                case 2: st = su->unpack(c); break;
+                case 3: st = su->unpack(e::unpack_varint(d)); break;
+                default: abort();
+            }
+
+            if (st == e::stream_unpacker::SUCCESS)
+            {
+                ++field;
+            }
+        }
+
+        return st;
+    }
+
+    int field;
+    uint32_t a;
+    e::slice b;
+    std::string bs;
+    std::vector<uint64_t> c;
+    uint64_t d;
+    size_t peak;
+};
+
+std::string
+message()
+{
+    std::string s;
+    std::vector<uint64_t> c(100, 0x0102030405060708ULL);
+    e::packer(&s) << uint32_t(0xdeadbeef) << e::slice(std::string(1000, 'x'))
+                  << c << e::pack_varint(1ULL << 50);
+    return s;
+}
+
+void
+check(const decoder& d)
+{
+    ASSERT_EQ(4, d.field);
+    ASSERT_EQ(0xdeadbeefU, d.a);
+    ASSERT_EQ(std::string(1000, 'x'), d.bs);
+    ASSERT_EQ(100U, d.c.size());
+    ASSERT_EQ(0x0102030405060708ULL, d.c[99]);
+    ASSERT_EQ(1ULL << 50, d.d);
+}
+
+TEST(StreamUnpackerTest, WholeMessage)
+{
+    std::string msg = message();
+    e::stream_unpacker su;
+    decoder d;
+    su.feed(e::slice(msg));
+    ASSERT_EQ(e::stream_unpacker::SUCCESS, d.run(&su));
+    check(d);
+    ASSERT_EQ(msg.size(), su.consumed());
+    ASSERT_EQ(0U, su.buffered());
+}
+
+TEST(StreamUnpackerTest, ChunkSizes)
+{
+    std::string msg = message();
+
+    for (size_t chunk = 1; chunk < 64; chunk += 7)
+    {
+        e::stream_unpacker su;
+        decoder d;
+
+        for (size_t off = 0; off < msg.size(); off += chunk)
+        {
+            // each chunk lives only until the next feed
+            std::string piece(msg.substr(off, chunk));
+            su.feed(e::slice(piece));
+            e::stream_unpacker::status st = d.run(&su);
+            ASSERT_NE(e::stream_unpacker::ERROR, st);
+        }
+
+        check(d);
+        ASSERT_EQ(msg.size(), su.consumed());
+        // never more than the largest field plus a chunk
+        ASSERT_LT(d.peak, 1002U + chunk);
+    }
+}
+
+TEST(StreamUnpackerTest, Error)
+{
+    // a slice that claims to be larger than the stream allows fails as soon
+    // as its length arrives
+    std::string msg;
+    e::packer(&msg) << e::slice(std::string(100, 'x'));
+    e::stream_unpacker su(50);
+    e::slice s;
+    su.feed(reinterpret_cast<const uint8_t*>(msg.data()), 40);
+    ASSERT_EQ(e::stream_unpacker::ERROR, su.unpack(s));
+    ASSERT_TRUE(su.error());
+    uint8_t x;
+    ASSERT_EQ(e::stream_unpacker::ERROR, su.unpack(x));
+
+    // an overlong varint fails without waiting for max_field bytes
+    std::string overlong(11, '\x80');
+    e::stream_unpacker bad;
+    uint64_t v;
+    bad.feed(reinterpret_cast<const uint8_t*>(overlong.data()), 9);
+    ASSERT_EQ(e::stream_unpacker::NEED_MORE, bad.unpack(e::unpack_varint(v)));
+    bad.feed(reinterpret_cast<const uint8_t*>(overlong.data()) + 9, 2);
+    ASSERT_EQ(e::stream_unpacker::ERROR, bad.unpack(e::unpack_varint(v)));
+}
+
+TEST(StreamUnpackerTest, Empty)
+{
+    // before the first feed and after draining every byte
+    e::stream_unpacker su;
+    uint32_t x = 0;
+    ASSERT_EQ(e::stream_unpacker::NEED_MORE, su.unpack(x));
+    std::string msg;
+    e::packer(&msg) << uint32_t(7);
+    su.feed(e::slice(msg));
+    ASSERT_EQ(e::stream_unpacker::SUCCESS, su.unpack(x));
+    ASSERT_EQ(7U, x);
+    ASSERT_EQ(0U, su.buffered());
+    ASSERT_EQ(e::stream_unpacker::NEED_MORE, su.unpack(x));
+    ASSERT_FALSE(su.error());
+}
+
+// Feed s a byte at a time until u no longer needs more.
+template <typename U>
+e::stream_unpacker::status
+feed_bytewise(const std::string& s, const U& u)
+{
+    e::stream_unpacker su;
+    e::stream_unpacker::status st = e::stream_unpacker::NEED_MORE;
+
+    for (size_t i = 0; i < s.size() && st == e::stream_unpacker::NEED_MORE; ++i)
+    {
+        su.feed(reinterpret_cast<const uint8_t*>(s.data()) + i, 1);
+        st = su.unpack(u);
+    }
+
+    return st;
+}
+
+TEST(StreamUnpackerTest, MalformedLists)
+{
+    // three gaps, the first of which never ends, and then the rest of the
+    // stream
+    std::vector<uint64_t> ids;
+    std::string delta;
+    e::packer(&delta) << e::pack_varint(3);
+    delta.append(11, '\x80');
+    delta.append(16, '\x01');
+    ASSERT_EQ(e::stream_unpacker::ERROR, feed_bytewise(delta, e::unpack_delta_varint(ids)));
+    // but a cut-short list waits for the rest
+    delta.resize(3);
+    ASSERT_EQ(e::stream_unpacker::NEED_MORE, feed_bytewise(delta, e::unpack_delta_varint(ids)));
+
+    // a count that never ends
+    std::vector<uint32_t> lens;
+    std::string group(11, '\x80');
+    group.append(16, '\x01');
+    ASSERT_EQ(e::stream_unpacker::ERROR, feed_bytewise(group, e::unpack_group_varint(lens)));
+    // a list cut short waits for the rest, and the whole list decodes
+    group.clear();
+    e::packer(&group) << e::pack_group_varint(std::vector<uint32_t>(6, UINT32_MAX));
+    ASSERT_EQ(e::stream_unpacker::SUCCESS, feed_bytewise(group, e::unpack_group_varint(lens)));
+    ASSERT_EQ(6U, lens.size());
+    group.resize(group.size() - 1);
+    ASSERT_EQ(e::stream_unpacker::NEED_MORE, feed_bytewise(group, e::unpack_group_varint(lens)));
+
+    // an array whose second value never ends
+    int64_t deltas[3];
+    std::string svarint(1, '\x01');
+    svarint.append(11, '\x80');
+    svarint.append(16, '\x01');
+    ASSERT_EQ(e::stream_unpacker::ERROR, feed_bytewise(svarint, e::unpack_svarint_array(deltas, 3)));
+    svarint.resize(3);
+    ASSERT_EQ(e::stream_unpacker::NEED_MORE, feed_bytewise(svarint, e::unpack_svarint_array(deltas, 3)));
+}
+
+// a slice that counts how often it is decoded
+struct counted
+{
+    counted() : s(), attempts(0) {}
+    e::slice s;
+    int attempts;
+};
+
+e::unpacker
+operator >> (e::unpacker up, counted& c)
+{
+    ++c.attempts;
+    return up >> c.s;
+}
+
+TEST(StreamUnpackerTest, WaitsForShortfall)
+{
+    std::string msg;
+    e::packer(&msg) << e::slice(std::string(1000, 'x'));
+    e::stream_unpacker su;
+    counted c;
+
+    for (size_t i = 0; i < msg.size(); ++i)
+    {
+        su.feed(reinterpret_cast<const uint8_t*>(msg.data()) + i, 1);
+        e::stream_unpacker::status st = su.unpack(c);
+        ASSERT_EQ(i + 1 < msg.size() ? e::stream_unpacker::NEED_MORE
+                                     : e::stream_unpacker::SUCCESS, st);
+    }
+
+    ASSERT_EQ(1000U, c.s.size());
+    // the first byte of the length, the length, and the whole slice
+    ASSERT_EQ(3, c.attempts);
+}
+
+} // namespace
@@ -6,7 +6,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
+// C
+#include <string.h>
+
 // STL
+#include <algorithm>
+#include <string>
 #include <vector>
 
 // e
@@ -138,3 +143,207 @@ TEST(Coding, Varint64Truncation)
     ASSERT_TRUE(e::varint64_decode(s.data(), s.data() + s.size(), &result) != NULL);
     ASSERT_EQ(large_value, result);
 }
+
+TEST(Coding, Varint64DecodeN)
+{
+    // runs of one-byte values long enough for the sixteen-byte path, mixed
+    // with every other length
+    std::vector<uint64_t> values;
+
+    for (uint32_t k = 0; k < 64; k++)
+    {
+        for (uint32_t j = 0; j < (k % 3 == 0 ? 20 : 1); ++j)
+        {
+            values.push_back(j * 5);
+        }
+
+        values.push_back(1ull << k);
+        values.push_back((1ull << k) - 1);
+    }
+
+    values.push_back(~static_cast<uint64_t>(0));
+    std::string s;
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        char buf[10];
+        char* ptr = e::varint64_encode(buf, values[i]);
+        s += std::string(buf, ptr - buf);
+    }
+
+    // every starting value, so each one lands on every path
+    for (size_t start = 0, off = 0; start < values.size();
+            off += e::varint_length(values[start]), ++start)
+    {
+        const size_t n = values.size() - start;
+        std::vector<uint64_t> out(n + 1, 0xdeadbeef);
+        const char* p = e::varint64_decode_n(s.data() + off, s.data() + s.size(), &out[0], n);
+        ASSERT_TRUE(p == s.data() + s.size());
+        ASSERT_TRUE(std::equal(out.begin(), out.begin() + n, values.begin() + start));
+        ASSERT_EQ(0xdeadbeefU, out[n]);
+
+        // asking for one more than there is fails
+        ASSERT_TRUE(e::varint64_decode_n(s.data() + off, s.data() + s.size(), &out[0], n + 1) == NULL);
+    }
+
+    // truncating the input anywhere fails
+    std::vector<uint64_t> out(values.size());
+
+    for (size_t len = 0; len < s.size(); ++len)
+    {
+        ASSERT_TRUE(e::varint64_decode_n(s.data(), s.data() + len, &out[0], values.size()) == NULL);
+    }
+
+    // eleven bytes with the continuation bit set
+    std::string overflow(32, '\x81');
+    ASSERT_TRUE(e::varint64_decode_n(overflow.data(), overflow.data() + overflow.size(), &out[0], 1) == NULL);
+    ASSERT_TRUE(e::varint64_decode_n(s.data(), s.data(), &out[0], 0) == s.data());
+}
+
+TEST(Coding, Varint64EncodeSlack)
+{
+    std::vector<uint64_t> values;
+    values.push_back(0);
+    values.push_back(~static_cast<uint64_t>(0));
+
+    for (uint32_t k = 0; k < 64; k++)
+    {
+        const uint64_t power = 1ull << k;
+        values.push_back(power);
+        values.push_back(power - 1);
+        values.push_back(power + 1);
+        values.push_back(power | 0x5555555555555555ULL);
+    }
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        char exact[VARINT_64_MAX_SIZE];
+        char slack[16];
+        char* exact_end = e::varint64_encode(exact, values[i]);
+        char* slack_end = e::varint64_encode_slack(slack, values[i]);
+        ASSERT_EQ(exact_end - exact, slack_end - slack);
+        ASSERT_EQ(e::varint_length(values[i]), exact_end - exact);
+        ASSERT_TRUE(memcmp(exact, slack, exact_end - exact) == 0);
+    }
+}
+
+TEST(Coding, GroupVarint)
+{
+    std::vector<uint32_t> values;
+    values.push_back(0);
+    values.push_back(UINT32_MAX);
+
+    for (uint32_t k = 0; k < 32; k++)
+    {
+        const uint32_t power = 1U << k;
+        values.push_back(power);
+        values.push_back(power - 1);
+        values.push_back(power + 1);
+    }
+
+    // every tag appears once values are taken four at a time
+    std::vector<uint32_t> lengths;
+    const uint32_t by_length[4] = {0x7f, 0x1234, 0xabcdef, 0x89abcdefU};
+
+    for (uint32_t tag = 0; tag < 256; tag++)
+    {
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            lengths.push_back(by_length[(tag >> (2 * i)) & 3]);
+        }
+    }
+
+    values.resize(values.size() / 4 * 4);
+    values.insert(values.end(), lengths.begin(), lengths.end());
+    std::string s;
+
+    for (size_t i = 0; i < values.size(); i += 4)
+    {
+        char buf[GROUP_VARINT_MAX_SIZE];
+        char* end = e::group_varint_encode(buf, &values[i]);
+        ASSERT_EQ(e::group_varint_length(&values[i]), end - buf);
+        s.append(buf, end);
+    }
+
+    std::vector<uint32_t> out(values.size());
+    const char* p = s.data();
+    const char* limit = p + s.size();
+
+    for (size_t i = 0; i < values.size(); i += 4)
+    {
+        const char* next = e::group_varint_decode(p, limit, &out[i]);
+        ASSERT_TRUE(next != NULL);
+        ASSERT_EQ(e::group_varint_length(&values[i]), next - p);
+
+        // the same group with nothing after it
+        std::string alone(p, next);
+        uint32_t group[4];
+        ASSERT_TRUE(e::group_varint_decode(alone.data(), alone.data() + alone.size(), group) ==
+                    alone.data() + alone.size());
+        ASSERT_TRUE(std::equal(group, group + 4, &values[i]));
+
+        for (size_t j = 0; j < alone.size(); j++)
+        {
+            ASSERT_TRUE(e::group_varint_decode(alone.data(), alone.data() + j, group) == NULL);
+        }
+
+        p = next;
+    }
+
+    ASSERT_TRUE(p == limit);
+    ASSERT_TRUE(values == out);
+}
+
+TEST(Coding, Svarint64)
+{
+    ASSERT_EQ(0U, e::zigzag_encode(0));
+    ASSERT_EQ(1U, e::zigzag_encode(-1));
+    ASSERT_EQ(2U, e::zigzag_encode(1));
+    ASSERT_EQ(UINT64_MAX - 1, e::zigzag_encode(INT64_MAX));
+    ASSERT_EQ(UINT64_MAX, e::zigzag_encode(INT64_MIN));
+
+    std::vector<int64_t> values;
+    values.push_back(INT64_MIN);
+    values.push_back(INT64_MAX);
+
+    for (uint32_t k = 0; k < 63; k++)
+    {
+        const int64_t power = static_cast<int64_t>(1ULL << k);
+        values.push_back(power);
+        values.push_back(-power);
+        values.push_back(power - 1);
+        values.push_back(1 - power);
+    }
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        ASSERT_EQ(values[i], e::zigzag_decode(e::zigzag_encode(values[i])));
+    }
+
+    // the exact space for every prefix, so both the slack and exact paths
+    // of the encoder run
+    for (size_t n = 0; n <= values.size(); n++)
+    {
+        size_t sz = 0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            sz += e::varint_length(e::zigzag_encode(values[i]));
+        }
+
+        std::vector<char> buf(sz + 1, 'x');
+        char* end = e::svarint64_encode_n(&buf[0], &buf[0] + sz, &values[0], n);
+        ASSERT_EQ(sz, end - &buf[0]);
+        ASSERT_EQ('x', buf[sz]);
+
+        std::vector<int64_t> out(n + 1, 7);
+        ASSERT_TRUE(e::svarint64_decode_n(&buf[0], end, &out[0], n) == end);
+        ASSERT_TRUE(std::equal(values.begin(), values.begin() + n, out.begin()));
+        ASSERT_EQ(7, out[n]);
+
+        if (n > 0)
+        {
+            ASSERT_TRUE(e::svarint64_decode_n(&buf[0], end - 1, &out[0], n) == NULL);
+        }
+    }
+}
@@ -8,6 +8,14 @@
 
 // C
 #include <stdlib.h>
+#include <string.h>
+
+// STL
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // e
 #include "e/varint.h"
@@ -15,6 +23,184 @@
 namespace
 {
 
+inline uint64_t
+load64le(const unsigned char* p)
+{
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+}
+
+inline uint32_t
+load32le(const unsigned char* p)
+{
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap32(x);
+#endif
+    return x;
+}
+
+// Where each of the four values of a group starts, and the size of the whole
+// group, indexed by the group's tag byte.
+struct group_layout
+{
+    uint8_t offset[4];
+    uint8_t size;
+};
+
+const group_layout group_layouts[256] = {
+    {{1, 2, 3, 4}, 5}, {{1, 3, 4, 5}, 6}, {{1, 4, 5, 6}, 7}, {{1, 5, 6, 7}, 8},
+    {{1, 2, 4, 5}, 6}, {{1, 3, 5, 6}, 7}, {{1, 4, 6, 7}, 8}, {{1, 5, 7, 8}, 9},
+    {{1, 2, 5, 6}, 7}, {{1, 3, 6, 7}, 8}, {{1, 4, 7, 8}, 9}, {{1, 5, 8, 9}, 10},
+    {{1, 2, 6, 7}, 8}, {{1, 3, 7, 8}, 9}, {{1, 4, 8, 9}, 10}, {{1, 5, 9, 10}, 11},
+    {{1, 2, 3, 5}, 6}, {{1, 3, 4, 6}, 7}, {{1, 4, 5, 7}, 8}, {{1, 5, 6, 8}, 9},
+    {{1, 2, 4, 6}, 7}, {{1, 3, 5, 7}, 8}, {{1, 4, 6, 8}, 9}, {{1, 5, 7, 9}, 10},
+    {{1, 2, 5, 7}, 8}, {{1, 3, 6, 8}, 9}, {{1, 4, 7, 9}, 10}, {{1, 5, 8, 10}, 11},
+    {{1, 2, 6, 8}, 9}, {{1, 3, 7, 9}, 10}, {{1, 4, 8, 10}, 11}, {{1, 5, 9, 11}, 12},
+    {{1, 2, 3, 6}, 7}, {{1, 3, 4, 7}, 8}, {{1, 4, 5, 8}, 9}, {{1, 5, 6, 9}, 10},
+    {{1, 2, 4, 7}, 8}, {{1, 3, 5, 8}, 9}, {{1, 4, 6, 9}, 10}, {{1, 5, 7, 10}, 11},
+    {{1, 2, 5, 8}, 9}, {{1, 3, 6, 9}, 10}, {{1, 4, 7, 10}, 11}, {{1, 5, 8, 11}, 12},
+    {{1, 2, 6, 9}, 10}, {{1, 3, 7, 10}, 11}, {{1, 4, 8, 11}, 12}, {{1, 5, 9, 12}, 13},
+    {{1, 2, 3, 7}, 8}, {{1, 3, 4, 8}, 9}, {{1, 4, 5, 9}, 10}, {{1, 5, 6, 10}, 11},
+    {{1, 2, 4, 8}, 9}, {{1, 3, 5, 9}, 10}, {{1, 4, 6, 10}, 11}, {{1, 5, 7, 11}, 12},
+    {{1, 2, 5, 9}, 10}, {{1, 3, 6, 10}, 11}, {{1, 4, 7, 11}, 12}, {{1, 5, 8, 12}, 13},
+    {{1, 2, 6, 10}, 11}, {{1, 3, 7, 11}, 12}, {{1, 4, 8, 12}, 13}, {{1, 5, 9, 13}, 14},
+    {{1, 2, 3, 4}, 6}, {{1, 3, 4, 5}, 7}, {{1, 4, 5, 6}, 8}, {{1, 5, 6, 7}, 9},
+    {{1, 2, 4, 5}, 7}, {{1, 3, 5, 6}, 8}, {{1, 4, 6, 7}, 9}, {{1, 5, 7, 8}, 10},
+    {{1, 2, 5, 6}, 8}, {{1, 3, 6, 7}, 9}, {{1, 4, 7, 8}, 10}, {{1, 5, 8, 9}, 11},
+    {{1, 2, 6, 7}, 9}, {{1, 3, 7, 8}, 10}, {{1, 4, 8, 9}, 11}, {{1, 5, 9, 10}, 12},
+    {{1, 2, 3, 5}, 7}, {{1, 3, 4, 6}, 8}, {{1, 4, 5, 7}, 9}, {{1, 5, 6, 8}, 10},
+    {{1, 2, 4, 6}, 8}, {{1, 3, 5, 7}, 9}, {{1, 4, 6, 8}, 10}, {{1, 5, 7, 9}, 11},
+    {{1, 2, 5, 7}, 9}, {{1, 3, 6, 8}, 10}, {{1, 4, 7, 9}, 11}, {{1, 5, 8, 10}, 12},
+    {{1, 2, 6, 8}, 10}, {{1, 3, 7, 9}, 11}, {{1, 4, 8, 10}, 12}, {{1, 5, 9, 11}, 13},
+    {{1, 2, 3, 6}, 8}, {{1, 3, 4, 7}, 9}, {{1, 4, 5, 8}, 10}, {{1, 5, 6, 9}, 11},
+    {{1, 2, 4, 7}, 9}, {{1, 3, 5, 8}, 10}, {{1, 4, 6, 9}, 11}, {{1, 5, 7, 10}, 12},
+    {{1, 2, 5, 8}, 10}, {{1, 3, 6, 9}, 11}, {{1, 4, 7, 10}, 12}, {{1, 5, 8, 11}, 13},
+    {{1, 2, 6, 9}, 11}, {{1, 3, 7, 10}, 12}, {{1, 4, 8, 11}, 13}, {{1, 5, 9, 12}, 14},
+    {{1, 2, 3, 7}, 9}, {{1, 3, 4, 8}, 10}, {{1, 4, 5, 9}, 11}, {{1, 5, 6, 10}, 12},
+    {{1, 2, 4, 8}, 10}, {{1, 3, 5, 9}, 11}, {{1, 4, 6, 10}, 12}, {{1, 5, 7, 11}, 13},
+    {{1, 2, 5, 9}, 11}, {{1, 3, 6, 10}, 12}, {{1, 4, 7, 11}, 13}, {{1, 5, 8, 12}, 14},
+    {{1, 2, 6, 10}, 12}, {{1, 3, 7, 11}, 13}, {{1, 4, 8, 12}, 14}, {{1, 5, 9, 13}, 15},
+    {{1, 2, 3, 4}, 7}, {{1, 3, 4, 5}, 8}, {{1, 4, 5, 6}, 9}, {{1, 5, 6, 7}, 10},
+    {{1, 2, 4, 5}, 8}, {{1, 3, 5, 6}, 9}, {{1, 4, 6, 7}, 10}, {{1, 5, 7, 8}, 11},
+    {{1, 2, 5, 6}, 9}, {{1, 3, 6, 7}, 10}, {{1, 4, 7, 8}, 11}, {{1, 5, 8, 9}, 12},
+    {{1, 2, 6, 7}, 10}, {{1, 3, 7, 8}, 11}, {{1, 4, 8, 9}, 12}, {{1, 5, 9, 10}, 13},
+    {{1, 2, 3, 5}, 8}, {{1, 3, 4, 6}, 9}, {{1, 4, 5, 7}, 10}, {{1, 5, 6, 8}, 11},
+    {{1, 2, 4, 6}, 9}, {{1, 3, 5, 7}, 10}, {{1, 4, 6, 8}, 11}, {{1, 5, 7, 9}, 12},
+    {{1, 2, 5, 7}, 10}, {{1, 3, 6, 8}, 11}, {{1, 4, 7, 9}, 12}, {{1, 5, 8, 10}, 13},
+    {{1, 2, 6, 8}, 11}, {{1, 3, 7, 9}, 12}, {{1, 4, 8, 10}, 13}, {{1, 5, 9, 11}, 14},
+    {{1, 2, 3, 6}, 9}, {{1, 3, 4, 7}, 10}, {{1, 4, 5, 8}, 11}, {{1, 5, 6, 9}, 12},
+    {{1, 2, 4, 7}, 10}, {{1, 3, 5, 8}, 11}, {{1, 4, 6, 9}, 12}, {{1, 5, 7, 10}, 13},
+    {{1, 2, 5, 8}, 11}, {{1, 3, 6, 9}, 12}, {{1, 4, 7, 10}, 13}, {{1, 5, 8, 11}, 14},
+    {{1, 2, 6, 9}, 12}, {{1, 3, 7, 10}, 13}, {{1, 4, 8, 11}, 14}, {{1, 5, 9, 12}, 15},
+    {{1, 2, 3, 7}, 10}, {{1, 3, 4, 8}, 11}, {{1, 4, 5, 9}, 12}, {{1, 5, 6, 10}, 13},
+    {{1, 2, 4, 8}, 11}, {{1, 3, 5, 9}, 12}, {{1, 4, 6, 10}, 13}, {{1, 5, 7, 11}, 14},
+    {{1, 2, 5, 9}, 12}, {{1, 3, 6, 10}, 13}, {{1, 4, 7, 11}, 14}, {{1, 5, 8, 12}, 15},
+    {{1, 2, 6, 10}, 13}, {{1, 3, 7, 11}, 14}, {{1, 4, 8, 12}, 15}, {{1, 5, 9, 13}, 16},
+    {{1, 2, 3, 4}, 8}, {{1, 3, 4, 5}, 9}, {{1, 4, 5, 6}, 10}, {{1, 5, 6, 7}, 11},
+    {{1, 2, 4, 5}, 9}, {{1, 3, 5, 6}, 10}, {{1, 4, 6, 7}, 11}, {{1, 5, 7, 8}, 12},
+    {{1, 2, 5, 6}, 10}, {{1, 3, 6, 7}, 11}, {{1, 4, 7, 8}, 12}, {{1, 5, 8, 9}, 13},
+    {{1, 2, 6, 7}, 11}, {{1, 3, 7, 8}, 12}, {{1, 4, 8, 9}, 13}, {{1, 5, 9, 10}, 14},
+    {{1, 2, 3, 5}, 9}, {{1, 3, 4, 6}, 10}, {{1, 4, 5, 7}, 11}, {{1, 5, 6, 8}, 12},
+    {{1, 2, 4, 6}, 10}, {{1, 3, 5, 7}, 11}, {{1, 4, 6, 8}, 12}, {{1, 5, 7, 9}, 13},
+    {{1, 2, 5, 7}, 11}, {{1, 3, 6, 8}, 12}, {{1, 4, 7, 9}, 13}, {{1, 5, 8, 10}, 14},
+    {{1, 2, 6, 8}, 12}, {{1, 3, 7, 9}, 13}, {{1, 4, 8, 10}, 14}, {{1, 5, 9, 11}, 15},
+    {{1, 2, 3, 6}, 10}, {{1, 3, 4, 7}, 11}, {{1, 4, 5, 8}, 12}, {{1, 5, 6, 9}, 13},
+    {{1, 2, 4, 7}, 11}, {{1, 3, 5, 8}, 12}, {{1, 4, 6, 9}, 13}, {{1, 5, 7, 10}, 14},
+    {{1, 2, 5, 8}, 12}, {{1, 3, 6, 9}, 13}, {{1, 4, 7, 10}, 14}, {{1, 5, 8, 11}, 15},
+    {{1, 2, 6, 9}, 13}, {{1, 3, 7, 10}, 14}, {{1, 4, 8, 11}, 15}, {{1, 5, 9, 12}, 16},
+    {{1, 2, 3, 7}, 11}, {{1, 3, 4, 8}, 12}, {{1, 4, 5, 9}, 13}, {{1, 5, 6, 10}, 14},
+    {{1, 2, 4, 8}, 12}, {{1, 3, 5, 9}, 13}, {{1, 4, 6, 10}, 14}, {{1, 5, 7, 11}, 15},
+    {{1, 2, 5, 9}, 13}, {{1, 3, 6, 10}, 14}, {{1, 4, 7, 11}, 15}, {{1, 5, 8, 12}, 16},
+    {{1, 2, 6, 10}, 14}, {{1, 3, 7, 11}, 15}, {{1, 4, 8, 12}, 16}, {{1, 5, 9, 13}, 17},
+};
+
+const uint32_t group_masks[4] = {0xffU, 0xffffU, 0xffffffU, 0xffffffffU};
+
+inline unsigned
+group_value_length(uint32_t v)
+{
+    return (32 - __builtin_clz(v | 1) + 7) / 8;
+}
+
+// Gather the low seven bits of each byte of x into the low 56 bits.
+inline uint64_t
+compact7(uint64_t x)
+{
+    x &= 0x7f7f7f7f7f7f7f7fULL;
+    x = (x & 0x007f007f007f007fULL) | ((x & 0x7f007f007f007f00ULL) >> 1);
+    x = (x & 0x00003fff00003fffULL) | ((x & 0x3fff00003fff0000ULL) >> 2);
+    x = (x & 0x000000000fffffffULL) | ((x & 0x0fffffff00000000ULL) >> 4);
+    return x;
+}
+
+inline void
+store64le(uint64_t x, unsigned char* p)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    memcpy(p, &x, sizeof(x));
+}
+
+// Spread the low 56 bits of x into the low seven bits of each byte; the
+// inverse of compact7.
+inline uint64_t
+spread7(uint64_t x)
+{
+    x = (x & 0x000000000fffffffULL) | ((x & 0x00fffffff0000000ULL) << 4);
+    x = (x & 0x00003fff00003fffULL) | ((x & 0x0fffc0000fffc000ULL) << 2);
+    x = (x & 0x007f007f007f007fULL) | ((x & 0x3f803f803f803f80ULL) << 1);
+    return x;
+}
+
+// One bit per byte of p[0..15], set where the byte's high bit is.
+inline unsigned
+continuation_mask(const unsigned char* p)
+{
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+#else
+    const uint64_t magic = 0x0002040810204081ULL;
+    const uint64_t lo = ((load64le(p) & 0x8080808080808080ULL) * magic) >> 56;
+    const uint64_t hi = ((load64le(p + 8) & 0x8080808080808080ULL) * magic) >> 56;
+    return lo | (hi << 8);
+#endif
+}
+
+// Zero-extend p[0..15] into out[0..15].
+inline void
+widen16(const unsigned char* p, uint64_t* out)
+{
+#ifdef __SSE2__
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i* dst = reinterpret_cast<__m128i*>(out);
+    const __m128i b[2] = {_mm_unpacklo_epi8(x, zero), _mm_unpackhi_epi8(x, zero)};
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        const __m128i w[2] = {_mm_unpacklo_epi16(b[i], zero), _mm_unpackhi_epi16(b[i], zero)};
+
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            _mm_storeu_si128(dst++, _mm_unpacklo_epi32(w[j], zero));
+            _mm_storeu_si128(dst++, _mm_unpackhi_epi32(w[j], zero));
+        }
+    }
+#else
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        out[i] = p[i];
+    }
+#endif
+}
+
 const char*
 decode_32_fallback(const char* p,
                    const char* limit,
@@ -92,6 +278,142 @@ e :: varint64_decode(const char* p, const char* limit, uint64_t* value)
     return NULL;
 }
 
+const char*
+e :: varint64_decode_n(const char* _p, const char* _limit, uint64_t* out, size_t n)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(_p);
+    const unsigned char* const limit = reinterpret_cast<const unsigned char*>(_limit);
+    size_t i = 0;
+
+    // Take the high bits of sixteen bytes at once and peel off every varint
+    // that ends within them.  Each is decoded with one load and a few masks,
+    // so neither finding nor decoding a varint branches on its bytes.  The
+    // loads reach up to eight bytes past the sixteen.
+    while (i < n && limit - p >= 24)
+    {
+        unsigned stops = ~continuation_mask(p) & 0xffff;
+
+        if (stops == 0xffff && n - i >= 16)
+        {
+            widen16(p, out + i);
+            p += 16;
+            i += 16;
+            continue;
+        }
+
+        if (stops == 0)
+        {
+            // no varint is that long
+            return NULL;
+        }
+
+        unsigned start = 0;
+
+        while (stops && i < n)
+        {
+            const unsigned end = __builtin_ctz(stops);
+            const unsigned len = end - start + 1;
+
+            if (len <= 8)
+            {
+                out[i] = compact7(load64le(p + start) & (~0ULL >> (64 - 8 * len)));
+            }
+            else if (len <= VARINT_64_MAX_SIZE)
+            {
+                // as varint64_decode does, keep only the low bit of a tenth byte
+                const unsigned char* v = p + start;
+                out[i] = compact7(load64le(v))
+                       | static_cast<uint64_t>(v[8] & 0x7f) << 56
+                       | (len == 10 ? static_cast<uint64_t>(v[9]) << 63 : 0);
+            }
+            else
+            {
+                return NULL;
+            }
+
+            ++i;
+            start = end + 1;
+            stops &= stops - 1;
+        }
+
+        p += start;
+    }
+
+    const char* ptr = reinterpret_cast<const char*>(p);
+
+    for (; i < n; ++i)
+    {
+        ptr = varint64_decode(ptr, _limit, out + i);
+
+        if (!ptr)
+        {
+            return NULL;
+        }
+    }
+
+    return ptr;
+}
+
+char*
+e :: varint64_encode_slack(char* dst, uint64_t v)
+{
+    unsigned char* ptr = reinterpret_cast<unsigned char*>(dst);
+
+    // single bytes dominate most workloads and predict well
+    if (v < 128)
+    {
+        *ptr = v;
+        return dst + 1;
+    }
+
+    const unsigned len = varint_length(v);
+    // continuation bits for every byte but the last, within the first eight
+    const unsigned more = std::min(len - 1, 8U);
+    const uint64_t lo = spread7(v) | (more ? 0x8080808080808080ULL >> (64 - 8 * more) : 0);
+    const uint64_t hi = ((v >> 56) & 0x7f) | (len == 10 ? 0x80 : 0) | ((v >> 63) << 8);
+    store64le(lo, ptr);
+    store64le(hi, ptr + 8);
+    return dst + len;
+}
+
+char*
+e :: svarint64_encode_n(char* dst, char* limit, const int64_t* in, size_t n)
+{
+    size_t i = 0;
+
+    for (; i < n && limit - dst >= 16; ++i)
+    {
+        dst = varint64_encode_slack(dst, zigzag_encode(in[i]));
+    }
+
+    for (; i < n; ++i)
+    {
+        dst = varint64_encode(dst, zigzag_encode(in[i]));
+    }
+
+    return dst;
+}
+
+const char*
+e :: svarint64_decode_n(const char* p, const char* limit, int64_t* out, size_t n)
+{
+    // signed and unsigned variants of a type may alias
+    uint64_t* u = reinterpret_cast<uint64_t*>(out);
+    p = varint64_decode_n(p, limit, u, n);
+
+    if (!p)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = zigzag_decode(u[i]);
+    }
+
+    return p;
+}
+
 char*
 e :: varint32_encode(char* dst, uint32_t v)
 {
@@ -148,3 +470,74 @@ e :: varint64_encode(char* dst, uint64_t v)
     *(ptr++) = static_cast<unsigned char>(v);
     return reinterpret_cast<char*>(ptr);
 }
+
+size_t
+e :: group_varint_length(const uint32_t* values)
+{
+    return 1 + group_value_length(values[0])
+             + group_value_length(values[1])
+             + group_value_length(values[2])
+             + group_value_length(values[3]);
+}
+
+char*
+e :: group_varint_encode(char* dst, const uint32_t* values)
+{
+    unsigned char* tag = reinterpret_cast<unsigned char*>(dst);
+    unsigned char* ptr = tag + 1;
+    *tag = 0;
+
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        const unsigned len = group_value_length(values[i]);
+        uint32_t v = values[i];
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap32(v);
+#endif
+        memcpy(ptr, &v, len);
+        ptr += len;
+        *tag |= (len - 1) << (2 * i);
+    }
+
+    return reinterpret_cast<char*>(ptr);
+}
+
+const char*
+e :: group_varint_decode(const char* _p, const char* _limit, uint32_t* values)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(_p);
+    const unsigned char* limit = reinterpret_cast<const unsigned char*>(_limit);
+
+    if (p >= limit)
+    {
+        return NULL;
+    }
+
+    const unsigned tag = *p;
+    const group_layout& g(group_layouts[tag]);
+
+    if (limit - p >= GROUP_VARINT_MAX_SIZE)
+    {
+        // every value is one unaligned load and a mask; the last load ends
+        // at most GROUP_VARINT_MAX_SIZE bytes in
+        values[0] = load32le(p + g.offset[0]) & group_masks[tag & 3];
+        values[1] = load32le(p + g.offset[1]) & group_masks[(tag >> 2) & 3];
+        values[2] = load32le(p + g.offset[2]) & group_masks[(tag >> 4) & 3];
+        values[3] = load32le(p + g.offset[3]) & group_masks[tag >> 6];
+        return _p + g.size;
+    }
+
+    if (limit - p < g.size)
+    {
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        unsigned char tmp[4] = {0, 0, 0, 0};
+        memcpy(tmp, p + g.offset[i], ((tag >> (2 * i)) & 3) + 1);
+        values[i] = load32le(tmp);
+    }
+
+    return _p + g.size;
+}